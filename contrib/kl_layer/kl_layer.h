@@ -1,8 +1,11 @@
 #ifndef KL_LAYER_H_
 #define KL_LAYER_H_
 
+#include "hls_stream.h"
 #include "nnet_activation.h"
 #include "nnet_common.h"
+#include "nnet_explogvar_stream.h"
+#include "nnet_types.h"
 #include <cmath>
 #include <cstdlib>
 
@@ -21,6 +24,17 @@ struct distance_config {
     // Internal info
     static const unsigned table_size = 1024;
     static constexpr unsigned exp_range = 8;
+
+    // Streaming versions: n_in = n_steps * n_elem values arrive over n_elem lanes (io_array_stream) or in packs
+    // (io_stream). exp(log_var) is the square of exp(0.5 * log_var) from explogvar. Its direct table is addressed
+    // by the truncated top bits of log_var, so squaring the entry biases the KL low; the range reduction is the
+    // default, the table shares its entries with the sampling layers
+    static const unsigned n_elem = 10;
+    static const unsigned reuse_factor = 1;
+    static const unsigned table_ports = 2;
+    static const explogvar_impl exp_impl = explogvar_impl::range_reduced;
+    static const unsigned mant_table_size = 32;
+    typedef ap_ufixed<18, 1> mant_table_t;
 };
 
 template <typename CONFIG_T, int N_TABLE> void init_klloss_exp_table(typename CONFIG_T::exp_table_t table_out[N_TABLE]) {
@@ -82,6 +96,87 @@ void klloss(data1_T mean[CONFIG_T::n_in], data2_T log_var[CONFIG_T::n_in], res_T
     kl_sum *= typename CONFIG_T::accum_t(1. / CONFIG_T::n_in);
     res[0] = res_T(-0.5) * kl_sum;
 }
+
+// 1 + log_var - mean^2 - exp(log_var) of one element, with exp(0.5 * log_var) from explogvar_exp_bank squared
+template <class data1_T, class data2_T, typename CONFIG_T, class bank_T>
+inline typename CONFIG_T::accum_t klloss_term(data1_T mean, data2_T log_var, const bank_T &exp_table, unsigned k) {
+    #pragma HLS INLINE
+    typename CONFIG_T::exp_table_t std_dev = exp_table.lookup(k, log_var);
+    typename CONFIG_T::accum_t term = typename CONFIG_T::accum_t(1.) + log_var;
+    term -= mean * mean;
+    term -= std_dev * std_dev;
+    return term;
+}
+
+// io_array_stream: one value per lane per timestep, the result is written once all n_in values are in
+template <class data1_T, class data2_T, class res_T, typename CONFIG_T>
+void klloss(hls::stream<data1_T> mean[CONFIG_T::n_elem], hls::stream<data2_T> log_var[CONFIG_T::n_elem],
+            hls::stream<res_T> res[CONFIG_T::n_out]) {
+    explogvar_exp_bank<data2_T, CONFIG_T, CONFIG_T::n_elem, CONFIG_T::reuse_factor> exp_table;
+    exp_table.init();
+
+    static const unsigned lanes_per_cycle = DIV_ROUNDUP(CONFIG_T::n_elem, CONFIG_T::reuse_factor);
+
+    typename CONFIG_T::accum_t kl_sum(0);
+    Op_add<typename CONFIG_T::accum_t> op_add;
+
+KLStepLoop:
+    for (unsigned s = 0; s < CONFIG_T::n_in / CONFIG_T::n_elem; s++) {
+    KLReuseLoop:
+        for (unsigned r = 0; r < CONFIG_T::reuse_factor; r++) {
+            #pragma HLS PIPELINE II=1
+            typename CONFIG_T::accum_t kl[lanes_per_cycle];
+            #pragma HLS ARRAY_PARTITION variable=kl complete
+        KLLaneLoop:
+            for (unsigned k = 0; k < lanes_per_cycle; k++) {
+                #pragma HLS UNROLL
+                unsigned j = r * lanes_per_cycle + k;
+                if (j >= CONFIG_T::n_elem) {
+                    kl[k] = 0;
+                    continue;
+                }
+                kl[k] = klloss_term<data1_T, data2_T, CONFIG_T>(mean[j].read(), log_var[j].read(), exp_table, k);
+            }
+            kl_sum += reduce<typename CONFIG_T::accum_t, lanes_per_cycle, Op_add<typename CONFIG_T::accum_t>>(kl, op_add);
+        }
+    }
+
+    kl_sum *= typename CONFIG_T::accum_t(1. / CONFIG_T::n_in);
+    res[0].write(res_T(-0.5) * kl_sum);
+}
+
+// io_stream: packs of data1_T::size values, the result is written as a pack of one
+template <class data1_T, class data2_T, class res_T, typename CONFIG_T>
+void klloss(hls::stream<data1_T> &mean, hls::stream<data2_T> &log_var, hls::stream<res_T> &res) {
+    typedef typename data2_T::value_type log_var_T;
+    explogvar_exp_bank<log_var_T, CONFIG_T, data2_T::size, 1> exp_table;
+    exp_table.init();
+
+    typename CONFIG_T::accum_t kl_sum(0);
+    Op_add<typename CONFIG_T::accum_t> op_add;
+
+KLPackLoop:
+    for (unsigned i = 0; i < CONFIG_T::n_in / data1_T::size; i++) {
+        #pragma HLS PIPELINE II=1
+        data1_T mean_pack = mean.read();
+        data2_T log_var_pack = log_var.read();
+
+        typename CONFIG_T::accum_t kl[data1_T::size];
+        #pragma HLS ARRAY_PARTITION variable=kl complete
+    KLPackElemLoop:
+        for (unsigned k = 0; k < data1_T::size; k++) {
+            #pragma HLS UNROLL
+            kl[k] = klloss_term<typename data1_T::value_type, log_var_T, CONFIG_T>(mean_pack[k], log_var_pack[k],
+                                                                                   exp_table, k);
+        }
+        kl_sum += reduce<typename CONFIG_T::accum_t, data1_T::size, Op_add<typename CONFIG_T::accum_t>>(kl, op_add);
+    }
+
+    kl_sum *= typename CONFIG_T::accum_t(1. / CONFIG_T::n_in);
+    res_T out_pack;
+    out_pack[0] = typename res_T::value_type(-0.5) * kl_sum;
+    res.write(out_pack);
+}
 } // namespace nnet
 
 #endif
@@ -21,7 +21,7 @@ from tensorflow.python.ops import math_ops
 
 import hls4ml
 from hls4ml.converters.keras_to_hls import parse_default_keras_layer
-from hls4ml.model.attributes import ConfigurableAttribute, TypeAttribute
+from hls4ml.model.attributes import ChoiceAttribute, ConfigurableAttribute, TypeAttribute
 from hls4ml.model.types import FixedPrecisionType, RoundingMode, SaturationMode
 
 
@@ -51,6 +51,8 @@ class HKLLoss(hls4ml.model.layers.Layer):
     _expected_attributes = [
         ConfigurableAttribute('table_size', default=1024),
         ConfigurableAttribute('exp_range', default=8),
+        # exp(log_var) of the streaming versions, see kl_layer.h
+        ChoiceAttribute('exp_implementation', ['table', 'range_reduced'], default='range_reduced'),
         TypeAttribute('accum'),
         TypeAttribute(
             'sum',
@@ -70,11 +72,14 @@ class HKLLoss(hls4ml.model.layers.Layer):
 distance_config_template = """struct config{index} : nnet::distance_config {{
     static const unsigned n_in = {n_in};
     static const unsigned n_out = 1;
+    static const unsigned n_elem = {n_elem};
+    static const unsigned reuse_factor = {reuse};
     typedef {accum_t.name} accum_t;
     typedef {sum_t.name} sum_t;
     typedef {exp_table_t.name} exp_table_t;
     static const unsigned table_size = {table_size};
     static constexpr float exp_range = {exp_range};
+    static const nnet::explogvar_impl exp_impl = nnet::explogvar_impl::{exp_implementation};
 }};\n"""
 distance_function_template = 'nnet::klloss<{input1_t}, {input2_t}, {output_t}, {config}>({input1}, {input2}, {output});'
 distance_include_list = ['nnet_utils/kl_layer.h']
@@ -87,7 +92,10 @@ class HKLLossConfigTemplate(hls4ml.backends.template.LayerConfigTemplate):
 
     def format(self, node):
         params = self._default_config_params(node)
-        params['n_in'] = node.get_input_variable(node.inputs[0]).shape[0]
+        shape = node.get_input_variable(node.inputs[0]).shape
+        params['n_in'] = int(np.prod(shape))
+        # Lanes of the io_array_stream version, the last dimension
+        params['n_elem'] = shape[-1]
         params['n_out'] = 1
         return self.template.format(**params)
 
@@ -121,7 +129,7 @@ def parse_klloss_layer(keras_layer, input_names, input_shapes, data_reader):
     return layer, output_shape
 
 
-def main():
+def register_kl_layer():
     # Register the converter for custom Keras layer
     hls4ml.converters.register_keras_layer_handler('KLLoss', parse_klloss_layer)
 
@@ -139,6 +147,10 @@ def main():
     p = Path(__file__).parent / 'kl_layer.h'
     backend.register_source(p)
 
+
+def main():
+    register_kl_layer()
+
     # Test if it works
     # Create a dummy Keras model with KL loss layer
     inp = tf.keras.layers.Input(shape=(19, 3, 1))
@@ -81,6 +81,8 @@ class FPGABackend(Backend):
 
         act_attrs = self.attribute_map.get(Activation, [])
         act_attrs.append(ConfigurableAttribute('table_size', default=1024))
+        # Channels per cycle sharing one copy of the table, io_array_stream only (see nnet::lut_bank)
+        act_attrs.append(ConfigurableAttribute('table_ports', default=2))
         act_attrs.append(TypeAttribute('table', default=FixedPrecisionType(18, 8)))
         self.attribute_map[Activation] = act_attrs
 
@@ -194,6 +196,91 @@ class FPGABackend(Backend):
 
         raise Exception(f'Cannot get mult size for layer {layer.name} ({layer.class_name})')
 
+    def get_recurrent_step_latency(self, layer):
+        """Estimated latency in cycles of the recurrent half of one GRU timestep.
+
+        h(t) depends on h(t-1) through the recurrent dense Wh*h(t-1), the recurrent activation (z, r), the reset
+        product, the activation of the candidate state and the final blend, so a loop over the timesteps cannot
+        start a step before the previous one is done: this latency is the smallest II the pipelined timestep loop
+        can meet. The dense takes about RecurrentReuseFactor cycles plus its adder tree, and a table-based
+        activation two cycles (one for the hard and piecewise-linear ones).
+        """
+        n_state = layer.get_attr('n_out')
+        recurrent_reuse_factor = layer.get_attr('recurrent_reuse_factor', layer.get_attr('reuse_factor', 1))
+
+        def activation_latency(activation):
+            return 1 if activation in ['linear', 'relu'] or 'hard' in activation else 2
+
+        dense_latency = recurrent_reuse_factor + int(math.ceil(math.log2(max(n_state, 2)))) + 1
+        return (
+            dense_latency
+            + activation_latency(layer.get_attr('recurrent_activation'))
+            + 2  # reset product and sum with the input projection
+            + activation_latency(layer.get_attr('activation'))
+            + 2  # blend of h(t-1) and the candidate state
+        )
+
+    def get_recurrent_ii(self, layer):
+        """II of the GRU timestep loop: `RecurrentII` when set, otherwise derived from the step latency.
+
+        With `NBatch` trials interleaved the dependence distance is n_batch iterations, so the derived II is the step
+        latency spread over the trials.
+        """
+        if layer.get_attr('recurrent_ii'):
+            return layer.get_attr('recurrent_ii')
+        n_batch = layer.get_attr('n_batch', 1)
+        return max(int(math.ceil(self.get_recurrent_step_latency(layer) / n_batch)), 1)
+
+    def get_layer_cost(self, layer):
+        """Static estimate of the work done by one call of a layer, reported by `ModelGraph.profile_performance()`.
+
+        Returns:
+            dict: The trip count of the loop over the timesteps, pixels or stream elements of the layer, the
+            multiply-accumulates, and the cycles, taking the reuse factor (or sequence II) as the initiation interval.
+            For an io_array_stream GRU the cycles follow its recurrent implementation: the serial loop pays the whole
+            step latency every timestep, the pipelined and precomputed ones (and the batched one) start a step every
+            recurrent II.
+        """
+        reuse_factor = layer.get_attr('reuse_factor', 1)
+        io_type = layer.model.config.get_config_value('IOType')
+
+        if 'Dense' in layer.class_name:
+            n_in, n_out = self.get_layer_mult_size(layer)
+            trip_count = layer.get_attr('n_sequence', 1)
+            ii = layer.get_attr('sequence_ii', reuse_factor)
+            return {'trip_count': trip_count, 'macs': trip_count * n_in * n_out, 'cycles': trip_count * ii}
+
+        if 'Conv1D' in layer.class_name or 'Conv2D' in layer.class_name:
+            n_in, n_out = self.get_layer_mult_size(layer)
+            trip_count = layer.get_attr('out_width') * layer.get_attr('out_height', 1)
+            return {'trip_count': trip_count, 'macs': trip_count * n_in * n_out, 'cycles': trip_count * reuse_factor}
+
+        if any(rnn in layer.class_name for rnn in ['LSTM', 'GRU', 'Bidirectional']):
+            n_in, n_out, n_in_recr, n_out_recr = self.get_layer_mult_size(layer)
+            n_directions = 2 if 'Bidirectional' in layer.class_name else 1
+            trip_count = layer.get_attr('n_timesteps')
+            macs = n_directions * trip_count * (n_in * n_out + n_in_recr * n_out_recr)
+            if layer.class_name == 'GRU' and io_type == 'io_array_stream':
+                # Only the array-stream GRU has a pipelined, precomputed or batched timestep loop
+                step_latency = self.get_recurrent_step_latency(layer)
+                implementation = layer.get_attr('recurrent_implementation', 'serial')
+                if implementation == 'serial' and layer.get_attr('n_batch', 1) == 1:
+                    # Each timestep runs the input projection, then the recurrent half, back to back
+                    cycles = trip_count * (reuse_factor + step_latency)
+                else:
+                    # The timestep loop (or the recurrent-only core behind the precomputed projection) starts a
+                    # step every recurrent II, plus the latency of the last step to drain
+                    ii = max(self.get_recurrent_ii(layer), reuse_factor)
+                    cycles = trip_count * ii + reuse_factor + step_latency
+                return {'trip_count': trip_count, 'macs': macs, 'cycles': cycles}
+            ii = max(reuse_factor, layer.get_attr('recurrent_reuse_factor', 1))
+            return {'trip_count': trip_count, 'macs': macs, 'cycles': trip_count * ii}
+
+        # Element-wise layers go through the stream one element (or one element per lane) at a time
+        shape = layer.get_output_variable().shape
+        trip_count = int(np.prod(shape[:-1])) if io_type in ['io_stream', 'io_array_stream'] else 1
+        return {'trip_count': trip_count, 'macs': 0, 'cycles': trip_count * reuse_factor}
+
     def get_valid_reuse_factors(self, n_in, n_out):
         max_rf = n_in * n_out
         valid_reuse_factors = []
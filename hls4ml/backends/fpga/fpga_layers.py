@@ -1,8 +1,8 @@
 import numpy as np
 
-from hls4ml.model.attributes import Attribute, ConfigurableAttribute, TypeAttribute
-from hls4ml.model.layers import Conv1D, Conv2D, Layer
-from hls4ml.model.types import IntegerPrecisionType, XnorPrecisionType
+from hls4ml.model.attributes import Attribute, ChoiceAttribute, ConfigurableAttribute, TypeAttribute
+from hls4ml.model.layers import Conv1D, Conv2D, Dense, Layer
+from hls4ml.model.types import FixedPrecisionType, IntegerPrecisionType, XnorPrecisionType
 
 
 class BatchNormalizationQuantizedTanh(Layer):
@@ -82,3 +82,18 @@ class PointwiseConv2D(Conv2D):
 
     # Nothing to do, will pick up function and config from class name
     pass
+
+
+class DenseActivation(Dense):
+    '''Dense layer with a relu, sigmoid, tanh or exp activation applied to its outputs as they are written.
+    ``dense_res_t`` is the type of the dense result before the activation. The sigmoid and tanh lookup
+    tables are banked over ``table_ports`` outputs, as in the array-stream activations, exp is range reduced.
+    '''
+
+    _expected_attributes = [
+        ChoiceAttribute('activation', ['relu', 'sigmoid', 'tanh', 'exp'], default='relu'),
+        ConfigurableAttribute('table_size', default=1024),
+        ConfigurableAttribute('table_ports', default=2),
+        TypeAttribute('table', default=FixedPrecisionType(18, 8)),
+        TypeAttribute('dense_res'),
+    ]
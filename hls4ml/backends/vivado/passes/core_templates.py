@@ -1,6 +1,15 @@
 from hls4ml.backends.backend import get_backend
 from hls4ml.backends.template import FunctionCallTemplate, LayerConfigTemplate
-from hls4ml.model.layers import Activation, BatchNormalization, Dense, HardActivation, ParametrizedActivation, PReLU, Softmax
+from hls4ml.model.layers import (
+    Activation,
+    BatchNormalization,
+    Dense,
+    HardActivation,
+    ParametrizedActivation,
+    PReLU,
+    Softmax,
+    TimeDistributedDense,
+)
 
 # Dense templates
 
@@ -56,6 +65,60 @@ class DenseFunctionTemplate(FunctionCallTemplate):
         return self.template.format(**params)
 
 
+# TimeDistributedDense templates
+
+td_dense_config_template = """struct config{index} : nnet::time_distributed_dense_config {{
+    static const unsigned n_in = {n_in};
+    static const unsigned n_out = {n_out};
+    static const unsigned n_sequence = {n_sequence};
+    static const unsigned sequence_ii = {sequence_ii};
+    static const unsigned io_type = nnet::{iotype};
+    static const unsigned strategy = nnet::{strategy};
+    static const unsigned reuse_factor = {reuse};
+    static const unsigned n_zeros = {nzeros};
+    static const unsigned n_nonzeros = {nonzeros};
+    static const unsigned multiplier_limit = DIV_ROUNDUP(n_in * n_out, reuse_factor) - n_zeros / reuse_factor;
+    static const bool store_weights_in_bram = false;
+    typedef {accum_t.name} accum_t;
+    typedef {bias_t.name} bias_t;
+    typedef {weight_t.name} weight_t;
+    typedef {index_t.name} index_t;
+    template<class x_T, class y_T>
+    using product = nnet::product::{product_type}<x_T, y_T>;
+}};\n"""
+
+td_dense_function_template = 'nnet::time_distributed_dense<{input_t}, {output_t}, {config}>({input}, {output}, {w}, {b});'
+
+
+class TimeDistributedDenseConfigTemplate(LayerConfigTemplate):
+    def __init__(self):
+        super().__init__(TimeDistributedDense)
+        self.template = td_dense_config_template
+
+    def format(self, node):
+        params = self._default_config_params(node)
+        params['nzeros'] = node.get_weights('weight').nzeros
+        params['nonzeros'] = node.get_weights('weight').nonzeros
+        params['product_type'] = get_backend('vivado').product_type(
+            node.get_input_variable().type.precision, node.get_weights('weight').type.precision
+        )
+
+        return self.template.format(**params)
+
+
+class TimeDistributedDenseFunctionTemplate(FunctionCallTemplate):
+    def __init__(self):
+        super().__init__(TimeDistributedDense, include_header=dense_include_list)
+        self.template = td_dense_function_template
+
+    def format(self, node):
+        params = self._default_function_params(node)
+        params['w'] = node.get_weights('weight').name
+        params['b'] = node.get_weights('bias').name
+
+        return self.template.format(**params)
+
+
 # BatchNormalization templates
 
 batchnorm_config_template = """struct config{index} : nnet::batchnorm_config {{
@@ -113,6 +176,7 @@ activ_config_template = """struct {type}_config{index} : nnet::activ_config {{
     static const unsigned table_size = {table_size};
     static const unsigned io_type = nnet::{iotype};
     static const unsigned reuse_factor = {reuse};
+    static const unsigned table_ports = {table_ports};
     typedef {table_t.name} table_t;
 }};\n"""
 
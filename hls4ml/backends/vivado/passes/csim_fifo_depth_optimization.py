@@ -0,0 +1,38 @@
+from hls4ml.model.optimizer.optimizer import ConfigurableOptimizerPass, ModelOptimizerPass
+
+
+def set_fifo_depth(model, depths):
+    for v in model.output_vars.values():
+        if type(v.pragma) is tuple and v.pragma[0] == 'stream' and v.name in depths:
+            # Never deepen a FIFO, the default depth already holds a whole sample
+            v.pragma = (v.pragma[0], max(1, min(v.pragma[1], depths[v.name] + 1)))
+
+
+class CsimFifoDepthOptimization(ConfigurableOptimizerPass, ModelOptimizerPass):
+    '''Sizes the FIFOs between the layers from their occupancy in C simulation, without RTL cosimulation.
+
+    The model is evaluated on `profiling_input` with its layers running as concurrent threads (see
+    `ModelGraph.profile_fifo_depths`), and each FIFO gets the largest occupancy seen plus one. Works with
+    `io_stream` and `io_array_stream`, where all the streams of an array share the depth of the fullest one.
+    '''
+
+    def __init__(self):
+        self.profiling_input = None
+
+    def transform(self, model):
+        if model.config.get_config_value('IOType') not in ['io_stream', 'io_array_stream']:
+            raise RuntimeError(
+                'To use this optimization you have to set `IOType` field to `io_stream` or `io_array_stream` in the HLS config'
+            )
+
+        if self.profiling_input is None:
+            raise RuntimeError(
+                'Set the input data to profile with '
+                '`get_optimizer(\'vivado:csim_fifo_depth_optimization\').configure(profiling_input=X)`'
+            )
+
+        depths = model.profile_fifo_depths(self.profiling_input)
+        set_fifo_depth(model, depths)
+
+        print('[hls4ml] - FIFO optimization from C simulation completed')
+        return False
@@ -0,0 +1,116 @@
+from copy import copy
+
+from hls4ml.backends.backend import get_backend
+from hls4ml.backends.fpga.fpga_layers import DenseActivation
+from hls4ml.backends.template import FunctionCallTemplate, LayerConfigTemplate
+from hls4ml.backends.vivado.passes.core_templates import dense_include_list
+from hls4ml.model.layers import register_layer
+from hls4ml.model.optimizer import OptimizerPass
+from hls4ml.model.types import NamedType
+
+dense_activation_config_template = """struct config{index} : nnet::dense_activation_config {{
+    static const unsigned n_in = {n_in};
+    static const unsigned n_out = {n_out};
+    static const unsigned io_type = nnet::{iotype};
+    static const unsigned strategy = nnet::{strategy};
+    static const unsigned reuse_factor = {reuse};
+    static const unsigned n_zeros = {nzeros};
+    static const unsigned n_nonzeros = {nonzeros};
+    static const unsigned multiplier_limit = DIV_ROUNDUP(n_in * n_out, reuse_factor) - n_zeros / reuse_factor;
+    static const bool store_weights_in_bram = false;
+    static const nnet::fused_activation activation = nnet::fused_activation::{activation};
+    static const unsigned table_size = {table_size};
+    static const unsigned table_ports = {table_ports};
+    typedef {accum_t.name} accum_t;
+    typedef {bias_t.name} bias_t;
+    typedef {weight_t.name} weight_t;
+    typedef {index_t.name} index_t;
+    typedef {dense_res_t.name} dense_res_t;
+    typedef {table_t.name} table_t;
+    template<class x_T, class y_T>
+    using product = nnet::product::{product_type}<x_T, y_T>;
+}};\n"""
+
+dense_activation_function_template = 'nnet::dense_activation<{input_t}, {output_t}, {config}>({input}, {output}, {w}, {b});'
+
+# Keras activation names of the activations the fused kernel implements. sigmoid and tanh read the tables of the
+# standalone activations, exp is computed by range reduction (see nnet_exp_range_reduced.h), accurate to about 1e-4
+# relative before the rounding to the output type
+fused_activations = {'relu': 'relu', 'sigmoid': 'sigmoid', 'tanh': 'tanh', 'exponential': 'exp', 'exp': 'exp'}
+
+
+class DenseActivationConfigTemplate(LayerConfigTemplate):
+    def __init__(self):
+        super().__init__(DenseActivation)
+        self.template = dense_activation_config_template
+
+    def format(self, node):
+        params = self._default_config_params(node)
+        params['nzeros'] = node.get_weights('weight').nzeros
+        params['nonzeros'] = node.get_weights('weight').nonzeros
+        params['product_type'] = get_backend('vivado').product_type(
+            node.get_input_variable().type.precision, node.get_weights('weight').type.precision
+        )
+
+        return self.template.format(**params)
+
+
+class DenseActivationFunctionTemplate(FunctionCallTemplate):
+    def __init__(self):
+        super().__init__(DenseActivation, include_header=dense_include_list)
+        self.template = dense_activation_function_template
+
+    def format(self, node):
+        params = self._default_function_params(node)
+        params['w'] = node.get_weights('weight').name
+        params['b'] = node.get_weights('bias').name
+
+        return self.template.format(**params)
+
+
+def register_dense_activation(backend):
+    # Register the layer types to the layer map
+    register_layer('DenseActivation', DenseActivation)
+
+    # Register the optimization passes
+    backend.register_pass('fuse_dense_activation', FuseDenseActivation)
+
+    # Register template passes
+    backend.register_template(DenseActivationConfigTemplate)
+    backend.register_template(DenseActivationFunctionTemplate)
+
+
+class FuseDenseActivation(OptimizerPass):
+    '''Fuses an activation into the preceding Dense layer in io_array_stream, removing the streams between them.'''
+
+    def match(self, node):
+        if node.model.config.get_config_value('IOType') != 'io_array_stream':
+            return False
+        if node.class_name != 'Activation' or node.get_attr('activation') not in fused_activations:
+            return False
+        input_node = node.get_input_node()
+        if input_node is None or input_node.class_name != 'Dense':
+            return False
+        # The dense result must not be read by other layers
+        return len(input_node.get_output_use_map()[input_node.name]) == 1
+
+    def transform(self, model, node):
+        dense = node.get_input_node()
+        activation = fused_activations[node.get_attr('activation')]
+        attrs = copy(dense.attributes)
+        attrs['activation'] = activation
+        attrs['table_size'] = node.get_attr('table_size')
+        if node.get_attr('table_ports') is not None:
+            attrs['table_ports'] = node.get_attr('table_ports')
+        attrs['table_t'] = node.get_attr('table_t')
+        attrs['dense_res_t'] = NamedType(dense.name + '_dense_res_t', dense.get_output_variable().type.precision)
+        output_precision = node.get_output_variable().type.precision
+
+        model.remove_node(node, rewire=True)
+        fused = model.make_node(DenseActivation, dense.name, attrs, dense.inputs.copy())
+        fused.weights['weight'].data = dense.weights['weight'].data
+        fused.weights['bias'].data = dense.weights['bias'].data
+        fused.get_output_variable().type.precision = output_precision
+        model.replace_node(dense, fused)
+
+        return True
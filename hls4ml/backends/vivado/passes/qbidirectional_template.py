@@ -131,6 +131,7 @@ bidirectional_config_template = """struct config{index} : nnet::bidirectional_co
     static const unsigned reuse_factor = {reuse};
     static const bool store_weights_in_bram = false;
     static const unsigned merge_mode = nnet::{merge_mode};
+    static const nnet::bidirectional_implementation implementation = nnet::bidirectional_implementation::{implementation};
 }};\n"""
 
 recr_function_template = 'nnet::bidirectional_array<{input_t}, {output_t}, {config}>({input}, {output}, {bw}, {bwr}, {bb}, {bbr}, {fw}, {fwr}, {fb}, {fbr});'
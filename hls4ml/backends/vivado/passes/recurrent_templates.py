@@ -83,6 +83,9 @@ recr_config_template = """struct config{index} : nnet::{recr_type}_config {{
     static const bool store_weights_in_bram = false;
     static const bool use_static = {static};
     static const bool use_initial = {initial_state};
+    static const nnet::recurrent_implementation implementation = nnet::recurrent_implementation::{recurrent_implementation};
+    static const unsigned recurrent_ii = {recurrent_ii};
+    static const unsigned n_batch = {n_batch};
     typedef {state_t} state_t;
     typedef {act} act_t;
     typedef {recr_act} recr_act_t;
@@ -112,8 +115,14 @@ class RecurrentConfigTemplate(LayerConfigTemplate):
             self.recr_act_template = recr_hard_activ_config_template
         params['n_in'] = node.get_input_variable().dim_names[1]
         params['n_sequence'] = node.get_input_variable().dim_names[0]
+        params['n_batch'] = node.get_attr('n_batch', 1)
+        if params['n_batch'] > 1:
+            # The timestep axis holds n_batch interleaved trials
+            params['n_sequence'] += ' / {}'.format(params['n_batch'])
         if node.get_attr('return_sequences'):
             params['n_sequence_out'] = node.get_output_variable().dim_names[0]
+            if params['n_batch'] > 1:
+                params['n_sequence_out'] += ' / {}'.format(params['n_batch'])
             params['n_state'] = node.get_output_variable().dim_names[1]
             params['n_out'] = node.get_output_variable().dim_names[1]
         else:
@@ -131,6 +140,8 @@ class RecurrentConfigTemplate(LayerConfigTemplate):
         params['state_t'] = 'state{}_t'.format(node.index)
         params['recr_act'] = 'recr_act{}_t'.format(node.index)
         params['act'] = 'act{}_t'.format(node.index)
+        params['recurrent_implementation'] = node.get_attr('recurrent_implementation', 'serial')
+        params['recurrent_ii'] = get_backend('vivado').get_recurrent_ii(node)
 
         if node.class_name == 'LSTM':
             n_recr_mult = 4
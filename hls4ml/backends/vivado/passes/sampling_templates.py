@@ -0,0 +1,63 @@
+import numpy as np
+
+from hls4ml.backends.template import FunctionCallTemplate, LayerConfigTemplate
+from hls4ml.model.layers import GaussianSample
+
+# GaussianSample templates
+
+sample_config_template = """struct config{index} : nnet::sample_config {{
+    static const unsigned n_elem = {n_elem};
+    static const unsigned n_steps = {n_steps};
+    static const unsigned n_samples = {n_samples};
+    static const bool interleave_samples = {interleave_samples};
+    static const unsigned table_size = {table_size};
+    static const unsigned table_ports = {table_ports};
+    static const nnet::explogvar_impl exp_impl = nnet::explogvar_impl::{exp_implementation};
+    static const unsigned mant_table_size = {mant_table_size};
+    static const unsigned n_uniforms = {n_uniforms};
+    static const unsigned seed = {seed};
+    static const nnet::grng_engine rng_engine = nnet::grng_engine::{rng_engine};
+    static const unsigned reuse_factor = {reuse};
+    static const unsigned multiplier_limit = DIV_ROUNDUP(n_elem, reuse_factor);
+    typedef {exp_table_t.name} exp_table_t;
+    typedef {mant_table_t.name} mant_table_t;
+    typedef {rnd_t.name} rnd_t;
+}};\n"""
+
+sample_function_template = 'nnet::sample<{mean_t}, {log_var_t}, {output_t}, {config}>({mean}, {log_var}, {output});'
+
+sample_include_list = ['nnet_utils/nnet_gaussian_sample_array_stream.h']
+
+
+class GaussianSampleConfigTemplate(LayerConfigTemplate):
+    def __init__(self):
+        super().__init__(GaussianSample)
+        self.template = sample_config_template
+
+    def format(self, node):
+        params = self._default_config_params(node)
+        shape = node.get_input_variable(node.inputs[0]).shape
+        # In io_array_stream the last dimension is spread over parallel streams (lanes)
+        params['n_elem'] = shape[-1]
+        params['n_steps'] = int(np.prod(shape[:-1]))
+        params['interleave_samples'] = str(node.get_attr('interleave_samples')).lower()
+
+        return self.template.format(**params)
+
+
+class GaussianSampleFunctionTemplate(FunctionCallTemplate):
+    def __init__(self):
+        super().__init__(GaussianSample, include_header=sample_include_list)
+        self.template = sample_function_template
+
+    def format(self, node):
+        params = {}
+        params['config'] = f'config{node.index}'
+        params['mean_t'] = node.get_input_variable(node.inputs[0]).type.name
+        params['log_var_t'] = node.get_input_variable(node.inputs[1]).type.name
+        params['output_t'] = node.get_output_variable().type.name
+        params['mean'] = node.get_input_variable(node.inputs[0]).name
+        params['log_var'] = node.get_input_variable(node.inputs[1]).name
+        params['output'] = node.get_output_variable().name
+
+        return self.template.format(**params)
@@ -18,15 +18,18 @@ from hls4ml.model.layers import (
     Embedding,
     GarNet,
     GarNetStack,
+    GaussianSample,
     GlobalPooling1D,
     GlobalPooling2D,
     Layer,
     Pooling1D,
     Pooling2D,
+    Reshape,
     SeparableConv1D,
     SeparableConv2D,
     SimpleRNN,
     Softmax,
+    TimeDistributedDense,
 )
 from hls4ml.model.optimizer import get_backend_passes, layer_optimizer
 from hls4ml.model.types import FixedPrecisionType, IntegerPrecisionType, NamedType
@@ -55,6 +58,28 @@ class VivadoBackend(FPGABackend):
             attrs.append(ConfigurableAttribute('static', value_type=bool, default=True))
             self.attribute_map[layer] = attrs
 
+        # With io_array_stream, the GRU timestep loop can be pipelined, overlapping the input projection of the next step
+        # with the recurrent half of the current one, or the input projection of the whole
+        # sequence can be precomputed ahead of a recurrent-only core. The recurrent half depends on
+        # the previous state, so the loop cannot reach an II below its latency (see
+        # get_recurrent_step_latency()); recurrent_ii = 0 (the default) uses that estimate, divided
+        # by n_batch when several trials are interleaved (see get_recurrent_ii()).
+        attrs = self.attribute_map.get(GRU, [])
+        attrs.append(
+            ChoiceAttribute('recurrent_implementation', ['serial', 'pipelined', 'precomputed'], default='serial')
+        )
+        attrs.append(ConfigurableAttribute('recurrent_ii', default=0))
+        # With io_array_stream, n_batch independent trials can share one GRU, interleaved along the
+        # timestep axis: (t0, trial 0), (t0, trial 1), ..., (t1, trial 0), ...
+        attrs.append(ConfigurableAttribute('n_batch', default=1))
+        self.attribute_map[GRU] = attrs
+
+        # Bidirectional can run its forward and backward layers one after the other, side by side,
+        # or with the forward layer streaming the input while the backward layer reads it back in reverse
+        attrs = self.attribute_map.get(Bidirectional, [])
+        attrs.append(ChoiceAttribute('implementation', ['sequential', 'concurrent', 'streaming'], default='sequential'))
+        self.attribute_map[Bidirectional] = attrs
+
         # Add ParallelizationFactor to Conv1D/2D
         pf_layers = [
             Conv1D,
@@ -101,6 +126,7 @@ class VivadoBackend(FPGABackend):
             'vivado:inplace_parallel_reshape',
             'vivado:inplace_stream_flatten',
             'vivado:skip_softmax',
+            'vivado:fuse_dense_activation',
         ]
         optimization_flow = register_flow('optimize', optimization_passes, requires=[init_flow], backend=self.name)
 
@@ -125,6 +151,12 @@ class VivadoBackend(FPGABackend):
 
         register_flow('fifo_depth_optimization', fifo_depth_opt_passes, requires=['vivado:ip'], backend=self.name)
 
+        csim_fifo_depth_opt_passes = ['vivado:csim_fifo_depth_optimization'] + writer_passes
+
+        register_flow(
+            'csim_fifo_depth_optimization', csim_fifo_depth_opt_passes, requires=['vivado:ip'], backend=self.name
+        )
+
         all_passes = get_backend_passes(self.name)
 
         extras = [
@@ -140,6 +172,7 @@ class VivadoBackend(FPGABackend):
             + templates
             + writer_passes
             + fifo_depth_opt_passes
+            + csim_fifo_depth_opt_passes
         ]
 
         if len(extras) > 0:
@@ -182,6 +215,7 @@ class VivadoBackend(FPGABackend):
         model,
         reset=False,
         csim=True,
+        csim_threads=1,
         synth=True,
         cosim=False,
         validation=False,
@@ -199,6 +233,7 @@ class VivadoBackend(FPGABackend):
         vivado_cmd = (
             f'vivado_hls -f build_prj.tcl "reset={reset} '
             f'csim={csim} '
+            f'csim_threads={csim_threads} '
             f'synth={synth} '
             f'cosim={cosim} '
             f'validation={validation} '
@@ -241,6 +276,21 @@ class VivadoBackend(FPGABackend):
             layer.set_attr('strategy', 'latency')
         layer.set_attr('index_t', NamedType(f'layer{layer.index}_index', index_t))
 
+    @layer_optimizer(TimeDistributedDense)
+    def init_time_distributed_dense(self, layer):
+        if layer.model.config.get_config_value('IOType') != 'io_array_stream':
+            raise Exception('TimeDistributedDense layer is only supported with io_array_stream.')
+        # A new timestep cannot start before the reused multipliers are free again
+        reuse_factor = int(layer.get_attr('reuse_factor'))
+        sequence_ii = layer.get_attr('sequence_ii')
+        if sequence_ii < reuse_factor:
+            if sequence_ii > 0:
+                print(
+                    f'WARNING: Invalid sequence II {sequence_ii} in layer "{layer.name}" '
+                    f'(must be at least the reuse factor). Using {reuse_factor} instead.'
+                )
+            layer.set_attr('sequence_ii', reuse_factor)
+
     # TODO consolidate these functions into a single `init_conv`
     @layer_optimizer(Conv1D)
     def init_conv1d(self, layer):
@@ -389,6 +439,24 @@ class VivadoBackend(FPGABackend):
         if layer.attributes['n_in'] is None:
             raise Exception('Input length of Embedding layer must be specified.')
 
+    @layer_optimizer(GaussianSample)
+    def init_gaussian_sample(self, layer):
+        if layer.model.config.get_config_value('IOType') != 'io_array_stream':
+            raise Exception('GaussianSample layer is only supported with io_array_stream.')
+        mean_shape = layer.get_input_variable(layer.inputs[0]).shape
+        log_var_shape = layer.get_input_variable(layer.inputs[1]).shape
+        if mean_shape != log_var_shape:
+            raise Exception(f'GaussianSample inputs must have the same shape, got {mean_shape} and {log_var_shape}.')
+        # The CLT engines wrap in rnd_t (the others saturate), so it has to hold their range of +-sqrt(3 * n_uniforms)
+        rnd_precision = layer.get_attr('rnd_t').precision
+        if layer.get_attr('rng_engine') in ['clt', 'philox']:
+            clt_range = np.sqrt(3 * layer.get_attr('n_uniforms'))
+            if clt_range > 2 ** (rnd_precision.integer - 1):
+                raise Exception(
+                    f'Layer {layer.name}: rnd_t {rnd_precision} cannot hold the +-{clt_range:.2f} range of '
+                    f'{layer.get_attr("n_uniforms")} uniforms, widen its integer bits.'
+                )
+
     @layer_optimizer(LSTM)
     def init_lstm(self, layer):
         # TODO Allow getting recurrent reuse factor from the config
@@ -416,7 +484,9 @@ class VivadoBackend(FPGABackend):
     @layer_optimizer(GRU)
     def init_gru(self, layer):
         reuse_factor = layer.model.config.get_reuse_factor(layer)
-        layer.set_attr('recurrent_reuse_factor', reuse_factor)
+        # The input projection (mult_config1) follows ReuseFactor, the recurrent dense can be set apart
+        recurrent_reuse_factor = layer.model.config.get_layer_config_value(layer, 'RecurrentReuseFactor', reuse_factor)
+        layer.set_attr('recurrent_reuse_factor', recurrent_reuse_factor)
 
         index_t = IntegerPrecisionType(width=1, signed=False)
 
@@ -434,6 +504,51 @@ class VivadoBackend(FPGABackend):
         else:
             layer.set_attr('strategy', 'latency')
 
+        # The posterior draws of a GaussianSample are run as the trials of the GRU
+        source = layer.get_input_node(layer.inputs[0])
+        while isinstance(source, Reshape):
+            source = source.get_input_node(source.inputs[0])
+        if isinstance(source, GaussianSample) and source.get_attr('n_samples') > 1:
+            n_samples = source.get_attr('n_samples')
+            interleaved = source.get_attr('interleave_samples')
+            if not interleaved or source.get_output_variable().shape != layer.get_input_variable().shape:
+                raise Exception(
+                    f'Layer {layer.name}: the {n_samples} draws of {source.name} must be interleaved along the timestep '
+                    'axis (interleave_samples) to be run as GRU trials'
+                )
+            if layer.get_attr('n_batch', 1) == 1:
+                layer.set_attr('n_batch', n_samples)
+            elif layer.get_attr('n_batch') != n_samples:
+                raise Exception(
+                    f'Layer {layer.name}: n_batch ({layer.get_attr("n_batch")}) must match the {n_samples} draws of '
+                    f'{source.name}'
+                )
+
+        io_type = layer.model.config.get_config_value('IOType')
+        if io_type != 'io_array_stream':
+            # The io_parallel and io_stream GRUs only have the serial timestep loop
+            implementation = layer.get_attr('recurrent_implementation', 'serial')
+            if implementation != 'serial':
+                raise Exception(
+                    f'Layer {layer.name}: RecurrentImplementation {implementation} is only supported with io_array_stream'
+                )
+            if layer.get_attr('recurrent_ii'):
+                raise Exception(f'Layer {layer.name}: RecurrentII is only supported with io_array_stream')
+        elif not layer.get_attr('recurrent_ii'):
+            layer.set_attr('recurrent_ii', self.get_recurrent_ii(layer))
+
+        n_batch = layer.get_attr('n_batch', 1)
+        if n_batch > 1:
+            if io_type != 'io_array_stream':
+                raise Exception(f'Layer {layer.name}: n_batch > 1 is only supported with io_array_stream')
+            if not layer.get_attr('return_sequences') or layer.get_attr('initial_state', False):
+                raise Exception(
+                    f'Layer {layer.name}: n_batch > 1 requires return_sequences=True and no initial state, '
+                    'the outputs and states of the trials are interleaved along the timestep axis'
+                )
+            if layer.get_attr('n_timesteps') % n_batch != 0:
+                raise Exception(f'Layer {layer.name}: the number of timesteps must be a multiple of n_batch ({n_batch})')
+
         layer.set_attr('index_t', index_t)
 
     @layer_optimizer(Bidirectional)
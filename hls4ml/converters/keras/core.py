@@ -50,6 +50,27 @@ def parse_dense_layer(keras_layer, input_names, input_shapes, data_reader):
     return layer, output_shape
 
 
+@keras_handler('TimeDistributed')
+def parse_time_distributed_layer(keras_layer, input_names, input_shapes, data_reader):
+    assert keras_layer['class_name'] == 'TimeDistributed'
+
+    wrapped_layer = keras_layer['config']['layer']
+    if wrapped_layer['class_name'] not in dense_layers:
+        raise Exception('Only Dense layers are supported in TimeDistributed layers')
+    if len(input_shapes[0]) < 3:
+        raise Exception(f'TimeDistributed layers expect a sequence input, got shape {input_shapes[0]}')
+
+    # The weights of the wrapped layer are stored under the name of the wrapper
+    wrapped_layer = {
+        'class_name': wrapped_layer['class_name'],
+        'config': dict(wrapped_layer['config'], name=keras_layer['config']['name']),
+    }
+    layer, output_shape = parse_dense_layer(wrapped_layer, input_names, input_shapes, data_reader)
+    layer['class_name'] = 'TimeDistributedDense'
+
+    return layer, output_shape
+
+
 activation_layers = ['Activation', 'LeakyReLU', 'ThresholdedReLU', 'ELU', 'PReLU', 'Softmax', 'ReLU']
 
 
@@ -0,0 +1,27 @@
+from hls4ml.converters.keras_to_hls import keras_handler, parse_default_keras_layer
+
+
+@keras_handler('GaussianSample')
+def parse_gaussian_sample_layer(keras_layer, input_names, input_shapes, data_reader):
+    assert keras_layer['class_name'] == 'GaussianSample'
+
+    layer = parse_default_keras_layer(keras_layer, input_names)
+
+    if len(layer['inputs']) != 2:
+        raise Exception('ERROR: GaussianSample expects two inputs, the mean and the log-variance.')
+    if 'seed' in keras_layer['config'] and keras_layer['config']['seed'] is not None:
+        layer['seed'] = keras_layer['config']['seed']
+
+    output_shape = input_shapes[0][:]
+    n_samples = keras_layer['config'].get('n_samples', 1)
+    if n_samples > 1:
+        # Posterior draws are stacked on a new axis after the batch
+        layer['n_samples'] = n_samples
+        if keras_layer['config'].get('interleave_samples', False) and len(output_shape) > 2:
+            # The draws of a timestep follow each other, the trial order of a GRU with n_batch = n_samples
+            layer['interleave_samples'] = True
+            output_shape = [output_shape[0], n_samples * output_shape[1]] + output_shape[2:]
+        else:
+            output_shape = [output_shape[0], n_samples] + output_shape[1:]
+
+    return layer, output_shape
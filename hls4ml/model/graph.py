@@ -1,10 +1,12 @@
 import ctypes
+import json
 import os
 import platform
 from collections import OrderedDict
 
 import numpy as np
 import numpy.ctypeslib as npc
+from tabulate import tabulate
 
 from hls4ml.backends import get_backend
 from hls4ml.model.flow import get_flow
@@ -48,6 +50,7 @@ class HLSConfig:
         self.layer_name_compression = {}
 
         self.trace_output = self.get_config_value('TraceOutput', False)
+        self.profile_output = self.get_config_value('ProfileOutput', False)
 
         self._parse_hls_config()
         self._validate_hls_config()
@@ -697,6 +700,22 @@ class ModelGraph:
 
         return top_function, ctype
 
+    def _get_batch_function(self, ctype):
+        suffix = '_batch_float' if ctype == ctypes.c_float else '_batch_double'
+        try:
+            batch_function = getattr(self._top_function_lib, self.config.get_project_name() + suffix)
+        except AttributeError:
+            # Library built from a project without the batch entry point
+            return None
+
+        n_args = len(self.get_input_variables()) + len(self.get_output_variables())
+        batch_function.restype = None
+        batch_function.argtypes = [ctypes.c_size_t, ctypes.c_uint] + [
+            npc.ndpointer(ctype, flags="C_CONTIGUOUS") for i in range(n_args)
+        ]
+
+        return batch_function
+
     def _compute_n_samples(self, x):
         if len(self.get_input_variables()) == 1:
             xlist = [x]
@@ -716,8 +735,23 @@ class ModelGraph:
 
         return int(n_sample)
 
-    def predict(self, x):
+    def predict(self, x, n_threads=1):
+        """Run C simulation of the compiled model.
+
+        Args:
+            x (np.ndarray or list): Input data, or a list of arrays for models with several inputs.
+            n_threads (int, optional): Number of threads used to evaluate the samples, 0 uses all cores.
+                With 1, the samples are evaluated in order and the state the layers keep between calls (the
+                hidden state of a recurrent stack with ``reset_state=False``, the random number generators of
+                sampling layers) carries over from one sample to the next, as in hardware. With more threads,
+                every sample starts from a fresh state, so the results do not depend on the thread count.
+                Has no effect with libraries compiled without the batch entry point. Defaults to 1.
+
+        Returns:
+            np.ndarray or list: Predictions, or a list of arrays for models with several outputs.
+        """
         top_function, ctype = self._get_top_function(x)
+        batch_function = self._get_batch_function(ctype)
         n_samples = self._compute_n_samples(x)
         n_inputs = len(self.get_input_variables())
         n_outputs = len(self.get_output_variables())
@@ -730,22 +764,14 @@ class ModelGraph:
             x = [x]
 
         try:
-            for i in range(n_samples):
-                predictions = [np.zeros(yj.size(), dtype=ctype) for yj in self.get_output_variables()]
-                if n_inputs == 1:
-                    inp = [np.asarray(x[i])]
-                else:
-                    inp = [np.asarray(xj[i]) for xj in x]
-                argtuple = inp
-                argtuple += predictions
-                argtuple = tuple(argtuple)
-                top_function(*argtuple)
-                output.append(predictions)
-
-            # Convert to list of numpy arrays (one for each output)
-            output = [
-                np.asarray([output[i_sample][i_output] for i_sample in range(n_samples)]) for i_output in range(n_outputs)
-            ]
+            if batch_function is not None:
+                # One call for the whole batch, the sample loop runs in C++
+                xlist = x if n_inputs > 1 or n_samples == 1 else [x]
+                inp = [np.ascontiguousarray(xj, dtype=ctype).reshape(n_samples, -1) for xj in xlist]
+                output = [np.zeros((n_samples, yj.size()), dtype=ctype) for yj in self.get_output_variables()]
+                batch_function(n_samples, n_threads, *inp, *output)
+            else:
+                output = self._predict_per_sample(top_function, ctype, x, n_samples)
         finally:
             os.chdir(curr_dir)
 
@@ -758,6 +784,26 @@ class ModelGraph:
         else:
             return output
 
+    def _predict_per_sample(self, top_function, ctype, x, n_samples):
+        n_inputs = len(self.get_input_variables())
+        n_outputs = len(self.get_output_variables())
+
+        output = []
+        for i in range(n_samples):
+            predictions = [np.zeros(yj.size(), dtype=ctype) for yj in self.get_output_variables()]
+            if n_inputs == 1:
+                inp = [np.asarray(x[i])]
+            else:
+                inp = [np.asarray(xj[i]) for xj in x]
+            argtuple = inp
+            argtuple += predictions
+            argtuple = tuple(argtuple)
+            top_function(*argtuple)
+            output.append(predictions)
+
+        # Convert to list of numpy arrays (one for each output)
+        return [np.asarray([output[i_sample][i_output] for i_sample in range(n_samples)]) for i_output in range(n_outputs)]
+
     def trace(self, x):
         print(f'Recompiling {self.config.get_project_name()} with tracing')
         self.config.trace_output = True
@@ -776,9 +822,10 @@ class ModelGraph:
         n_traced = 0
         for layer in self.get_layers():
             if layer.get_attr('function_cpp', None) and layer.get_attr('trace', False):
-                n_traced += len(layer.get_variables())
-                trace_output[layer.name] = []
-                layer_sizes[layer.name] = layer.get_output_variable().shape
+                for trace_name, var in layer.get_trace_variables():
+                    n_traced += 1
+                    trace_output[trace_name] = []
+                    layer_sizes[trace_name] = var.shape
 
         collect_func = self._top_function_lib.collect_trace_output
         collect_func.argtypes = [ctypes.POINTER(TraceData)]
@@ -842,6 +889,110 @@ class ModelGraph:
         else:
             return output, trace_output
 
+    def profile_performance(self, x, print_table=True):
+        """Profile the layers of the model in C simulation.
+
+        The model is recompiled with every layer call timed, with the layers running one after the other, and
+        evaluated on `x`. For every layer, the profile holds the number of calls, the estimated trip count (of the
+        loop over timesteps, pixels or stream elements), multiply-accumulates and cycles of one call, taking the
+        reuse factor as the initiation interval (see `get_layer_cost()` of the backend), and the measured
+        wall-clock time. The profile is also written to `layer_profile.json` in the output directory.
+
+        Args:
+            x (np.ndarray or list): Input data, or a list of arrays for models with several inputs.
+            print_table (bool, optional): Print the profile as a table. Defaults to True.
+
+        Returns:
+            dict: The profile of every layer, by layer name in execution order.
+        """
+        print(f'Recompiling {self.config.get_project_name()} with profiling')
+        self.config.profile_output = True
+        self.compile()
+
+        self.predict(x)
+
+        filename = os.path.abspath(os.path.join(self.config.get_output_dir(), 'layer_profile.json'))
+        write_func = self._top_function_lib.write_layer_profile
+        write_func.argtypes = [ctypes.c_char_p]
+        write_func.restype = None
+        write_func(filename.encode('utf-8'))
+
+        with open(filename) as f:
+            profile = json.load(f)
+
+        for name, layer_profile in profile.items():
+            layer_profile['class_name'] = self.graph[name].class_name
+            calls = max(layer_profile['invocations'], 1)
+            layer_profile['wall_time_per_call'] = layer_profile['wall_time'] / calls
+
+        if print_table:
+            total_time = sum(p['wall_time'] for p in profile.values())
+            rows = [
+                [
+                    name,
+                    p['class_name'],
+                    p['invocations'],
+                    p['trip_count'],
+                    p['macs'],
+                    p['cycles'],
+                    p['wall_time_per_call'] * 1e6,
+                    100 * p['wall_time'] / total_time if total_time > 0 else 0,
+                ]
+                for name, p in profile.items()
+            ]
+            headers = ['Layer', 'Class', 'Calls', 'Trip count', 'MACs', 'Est. cycles', 'Time/call [us]', 'Time [%]']
+            print(tabulate(rows, headers=headers, tablefmt='orgtbl', floatfmt='.1f'))
+
+        return profile
+
+    def profile_fifo_depths(self, x):
+        """Measure the occupancy of the FIFOs between the layers of a streaming model in C simulation.
+
+        The model is recompiled with its layers running as concurrent threads, connected by ring buffer streams
+        bounded by their current depths, and with FIFO instrumentation (see `HLS4ML_DATAFLOW_THREADS`,
+        `HLS4ML_STREAM_RING_BUFFER` and `HLS4ML_FIFO_DEPTHS` in build_lib.sh), then evaluated on `x`. Every
+        stream transfer yields the thread, so data is consumed as soon as it is produced and the occupancy
+        does not depend on the number of cores. The profile is also written to `fifo_depths.json` in the
+        output directory. The model is then recompiled as before, so later calls to `predict()` do not run the
+        instrumented build.
+
+        Args:
+            x (np.ndarray or list): Input data, or a list of arrays for models with several inputs.
+
+        Returns:
+            dict: The largest number of elements each stream (or array of streams) held, by variable name.
+        """
+        if self.config.get_config_value('IOType') not in ['io_stream', 'io_array_stream']:
+            raise Exception('FIFO depths can only be profiled with io_stream or io_array_stream')
+
+        print(f'Recompiling {self.config.get_project_name()} with FIFO profiling')
+        profiling_env = {'HLS4ML_DATAFLOW_THREADS': '1', 'HLS4ML_STREAM_RING_BUFFER': '1', 'HLS4ML_FIFO_DEPTHS': '1'}
+        saved_env = {key: os.environ.get(key) for key in profiling_env}
+        os.environ.update(profiling_env)
+        try:
+            self.compile()
+        finally:
+            for key, value in saved_env.items():
+                if value is None:
+                    del os.environ[key]
+                else:
+                    os.environ[key] = value
+
+        try:
+            self.predict(x)
+
+            filename = os.path.abspath(os.path.join(self.config.get_output_dir(), 'fifo_depths.json'))
+            write_func = self._top_function_lib.write_fifo_depths
+            write_func.argtypes = [ctypes.c_char_p]
+            write_func.restype = None
+            write_func(filename.encode('utf-8'))
+        finally:
+            print(f'Recompiling {self.config.get_project_name()} without FIFO profiling')
+            self.compile()
+
+        with open(filename) as f:
+            return json.load(f)
+
     def build(self, **kwargs):
         """Builds the generated project using HLS compiler.
 
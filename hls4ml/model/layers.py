@@ -236,6 +236,13 @@ class Layer:
     def get_variables(self):
         return self.variables.values()
 
+    def get_trace_variables(self):
+        '''Output variables, each with the name its trace is stored under.
+
+        The first output is traced under the name of the layer, and any further output under its own output name.
+        '''
+        return [(self.name if i == 0 else out_name, var) for i, (out_name, var) in enumerate(self.variables.items())]
+
     def add_output_variable(
         self, shape, dim_names, out_name=None, var_name='layer{index}_out', type_name='layer{index}_t', precision=None
     ):
@@ -407,6 +414,23 @@ class Dense(Layer):
         self.add_bias(quantizer=self.get_attr('bias_quantizer'))
 
 
+class TimeDistributedDense(Dense):
+    '''
+    Dense layer applied independently to each of the ``n_sequence`` timesteps of a sequence, with
+    the same weights. In ``io_array_stream`` the weights stay resident while the timesteps stream
+    through, one every ``sequence_ii`` cycles (0 follows the reuse factor).
+    '''
+
+    _expected_attributes = [
+        Attribute('n_sequence'),
+        ConfigurableAttribute('sequence_ii', default=0),
+    ]
+
+    def initialize(self):
+        super().initialize()
+        self.set_attr('n_sequence', int(np.prod(self.get_input_variable().shape[:-1])))
+
+
 class Conv1D(Layer):
     _expected_attributes = [
         Attribute('in_width'),
@@ -977,6 +1001,53 @@ class Embedding(Layer):
         self.add_weights_variable(name='embeddings', var_name='e{index}', data=data)
 
 
+class GaussianSample(Layer):
+    '''
+    Reparameterization sample of a diagonal Gaussian, ``mean + N(0, 1) * exp(0.5 * log_var)``.
+    Takes two inputs of equal shape, the mean and the log-variance. The normal variates come from
+    ``rng_engine``, seeded with ``seed``: ``clt`` sums ``n_uniforms`` uniform variates per lane,
+    ``clt_shift``, ``inverse_cdf`` and ``wallace`` trade distribution quality for fewer resources,
+    ``philox`` is counter-based so every (trial, timestep) can be generated independently
+    (see ``nnet_gaussian_sample_array_stream.h``). With ``n_samples`` > 1 the inputs are read
+    once and ``n_samples`` draws are emitted back to back, as a new leading output dimension, or with
+    ``interleave_samples`` one timestep at a time, as ``n_samples`` trials of a GRU with ``n_batch = n_samples``.
+    ``exp_implementation`` computes ``exp(0.5 * log_var)`` with a ``table_size`` direct table or,
+    with ``range_reduced``, by interpolating a ``mant_table_size`` table of 2^f and shifting. Each
+    copy of the direct table serves ``table_ports`` of the lanes read in a cycle.
+    '''
+
+    _expected_attributes = [
+        ConfigurableAttribute('table_size', default=1024),
+        ConfigurableAttribute('table_ports', default=2),
+        ChoiceAttribute('exp_implementation', ['table', 'range_reduced'], default='table'),
+        ConfigurableAttribute('mant_table_size', default=32),
+        ChoiceAttribute('rng_engine', ['clt', 'clt_shift', 'inverse_cdf', 'wallace', 'philox'], default='clt'),
+        ConfigurableAttribute('n_uniforms', default=4),
+        ConfigurableAttribute('seed', default=42),
+        Attribute('n_samples', default=1),
+        Attribute('interleave_samples', value_type=bool, default=False),
+        TypeAttribute(
+            'exp_table', default=FixedPrecisionType(18, 8, rounding_mode='RND_CONV', saturation_mode='SAT')
+        ),
+        TypeAttribute('mant_table', default=FixedPrecisionType(18, 1, signed=False)),
+        TypeAttribute('rnd', default=FixedPrecisionType(8, 3)),
+    ]
+
+    def initialize(self):
+        inp = self.get_input_variable(self.inputs[0])
+        n_samples = self.get_attr('n_samples')
+        if n_samples > 1 and self.get_attr('interleave_samples'):
+            shape = [n_samples * inp.shape[0]] + inp.shape[1:]
+            dims = [f'N_SAMPLES_{self.index}'] + inp.dim_names[1:]
+        elif n_samples > 1:
+            shape = [n_samples] + inp.shape
+            dims = [f'N_SAMPLES_{self.index}'] + inp.dim_names
+        else:
+            shape = inp.shape
+            dims = inp.dim_names
+        self.add_output_variable(shape, dims)
+
+
 class SimpleRNN(Layer):
     _expected_attributes = [
         Attribute('n_out'),
@@ -1472,6 +1543,7 @@ layer_map = {
     'BinaryDense': Dense,
     'TernaryDense': Dense,
     'QDense': Dense,
+    'TimeDistributedDense': TimeDistributedDense,
     'Conv1D': Conv1D,
     'QConv1D': Conv1D,
     'Conv2D': Conv2D,
@@ -1501,6 +1573,7 @@ layer_map = {
     'UpSampling2D': Resize,
     'Transpose': Transpose,
     'Embedding': Embedding,
+    'GaussianSample': GaussianSample,
     'SimpleRNN': SimpleRNN,
     'LSTM': LSTM,
     'GRU': GRU,
@@ -1,6 +1,6 @@
 import numpy as np
 
-from hls4ml.model.layers import Dense
+from hls4ml.model.layers import Dense, TimeDistributedDense
 from hls4ml.model.optimizer import OptimizerPass
 
 
@@ -8,11 +8,13 @@ class ReplaceMultidimensionalDenseWithConv(OptimizerPass):
     def match(self, node):
         return (
             isinstance(node, Dense)
+            and not isinstance(node, TimeDistributedDense)
             and len(node.get_input_variable().shape) - sum(d == 1 for d in node.get_input_variable().shape) > 1
         )
         # The above sum checks for the number of dimensions in the Dense with size 1
         # The subtraction allows the check to only count the number of dimensions with non-1 size
         # For example, this prevents matching for a Dense layer with shape (1,N)
+        # TimeDistributedDense has its own sequence kernel and is kept as is
 
     def transform(self, model, node):
         dim = len(node.get_input_variable().shape) - 1
@@ -85,6 +85,14 @@
 #ifdef HLS_STREAM_THREAD_SAFE
 #include <mutex>
 #include <condition_variable>
+#include <thread>
+#endif
+
+#ifdef HLS_STREAM_RING_BUFFER
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
 #endif
 
 #ifndef _MSC_VER
@@ -94,11 +102,332 @@
 
 namespace hls {
 
+#ifdef HLS_STREAM_RING_BUFFER
+
+// Single-producer/single-consumer ring buffer model of hls::stream, selected with HLS_STREAM_RING_BUFFER.
+// The elements live in a power-of-two array sized from the stream depth (set_depth, the value of the
+// STREAM pragma, HLS_STREAM_RING_DEFAULT_DEPTH until set) and allocated on the first write. The
+// producer only advances _tail and the consumer only _head, so neither takes a lock; the two indices
+// are kept on separate cache lines.
+// Without HLS_STREAM_THREAD_SAFE, producer and consumer run one after the other: a full ring doubles
+// in size and reading an empty one warns, as in the std::deque model. With HLS_STREAM_THREAD_SAFE, they
+// may run on different threads: a full FIFO (write) or an empty one (read) is waited on, spinning
+// first and then parking the thread until the other side makes progress. The FIFO is full when it holds
+// depth elements, as in hardware, even though the ring itself is rounded up to a power of two. Only
+// streams given a depth with set_depth are bounded: the FIFOs inside a kernel have no depth in C
+// simulation and their DATAFLOW processes still run one after the other, so they grow as in the
+// sequential model, with the consumer taking a lock around the ring. HLS_STREAM_YIELD additionally
+// yields the thread after every transfer, which keeps the FIFOs as empty as the dataflow allows.
+#ifndef HLS_STREAM_RING_DEFAULT_DEPTH
+#define HLS_STREAM_RING_DEFAULT_DEPTH 64
+#endif
+
+#ifndef HLS_STREAM_RING_SPIN
+#define HLS_STREAM_RING_SPIN 1024
+#endif
+
 template<typename __STREAM_T__>
 class stream
 {
   protected:
+    static const size_t _cache_line = 64;
+
     std::string _name;
+    size_t _depth;
+    bool _sized; // depth set with set_depth, bounding the threaded FIFO
+    std::unique_ptr<__STREAM_T__[]> _data; // _mask + 1 slots
+    size_t _mask;
+    size_t _high_water; // written by the producer
+    void (*_tap)(void *, const __STREAM_T__ &);
+    void *_tap_context;
+
+    char _pad0[_cache_line];
+    std::atomic<size_t> _head; // next slot to read, written by the consumer
+    char _pad1[_cache_line - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> _tail; // next slot to write, written by the producer
+    char _pad2[_cache_line - sizeof(std::atomic<size_t>)];
+
+#ifdef HLS_STREAM_THREAD_SAFE
+    // Parking of a waiting producer or consumer
+    std::atomic<int> _parked{0};
+    std::mutex _park_mutex;
+    std::condition_variable _park_cv;
+    // Held while an unsized ring grows, and by its consumer around every access to the ring
+    std::mutex _grow_mutex;
+#endif
+
+  public:
+    /// Constructors
+    // Keep consistent with the synthesis model's constructors
+    stream()
+        : _depth(HLS_STREAM_RING_DEFAULT_DEPTH), _sized(false), _mask(0), _high_water(0), _tap(0), _tap_context(0),
+          _head(0), _tail(0) {
+        static unsigned _counter = 1;
+        std::stringstream ss;
+#ifndef _MSC_VER
+        char* _demangle_name = abi::__cxa_demangle(typeid(*this).name(), 0, 0, 0);
+        if (_demangle_name) {
+            _name = _demangle_name;
+            free(_demangle_name);
+        }
+        else {
+            _name = "hls_stream";
+        }
+#else
+        _name = typeid(*this).name();
+#endif
+
+        ss << _counter++;
+        _name += "." + ss.str();
+    }
+
+    stream(const std::string name)
+        : _name(name), _depth(HLS_STREAM_RING_DEFAULT_DEPTH), _sized(false), _mask(0), _high_water(0), _tap(0),
+          _tap_context(0), _head(0), _tail(0) {}
+
+  /// Make copy constructor and assignment operator private
+  private:
+    stream(const stream< __STREAM_T__ >& chn);
+    stream& operator = (const stream< __STREAM_T__ >& chn);
+
+  public:
+    /// Overload >> and << operators to implement read() and write()
+    void operator >> (__STREAM_T__& rdata) {
+        read(rdata);
+    }
+
+    void operator << (const __STREAM_T__& wdata) {
+        write(wdata);
+    }
+
+  public:
+    /// Destructor
+    /// Check status of the queue
+    virtual ~stream() {
+        if (!empty())
+        {
+            std::cout << "WARNING: Hls::stream '"
+                      << _name
+                      << "' contains leftover data,"
+                      << " which may result in RTL simulation hanging."
+                      << std::endl;
+        }
+    }
+
+    /// Capacity of the ring, the depth of the STREAM pragma. Takes effect if set before the first write.
+    void set_depth(size_t depth) {
+        _depth = depth;
+        _sized = true;
+    }
+
+    size_t depth() const { return _depth; }
+
+    /// Largest number of elements the stream held at once
+    size_t high_water_mark() const { return _high_water; }
+
+    /// Function called with every element written, for tracing in C simulation
+    typedef void (*tap_function)(void *context, const __STREAM_T__ &elem);
+
+    void set_tap(tap_function tap, void *context) {
+        _tap = tap;
+        _tap_context = context;
+    }
+
+    /// Status of the queue
+    bool empty() {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+    bool full() const {
+#ifdef HLS_STREAM_THREAD_SAFE
+        // An unsized ring grows instead
+        return _sized && _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire) >= bound();
+#else
+        // The sequential ring grows instead
+        return false;
+#endif
+    }
+
+    /// Blocking read
+    void read(__STREAM_T__& head) {
+        head = read();
+    }
+
+    __STREAM_T__ read() {
+        __STREAM_T__ elem;
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (!wait_for_data(head)) {
+            std::cout << "WARNING: Hls::stream '"
+                      << _name
+                      << "' is read while empty,"
+                      << " which may result in RTL simulation hanging."
+                      << std::endl;
+            return __STREAM_T__();
+        }
+        elem = load(head);
+        _head.store(head + 1, std::memory_order_release);
+        wake();
+        return elem;
+    }
+
+    /// Blocking write
+    void write(const __STREAM_T__& tail) {
+        size_t pos = _tail.load(std::memory_order_relaxed);
+        make_room(pos);
+        _data[pos & _mask] = tail;
+        size_t used = pos + 1 - _head.load(std::memory_order_relaxed);
+        if (used > _high_water)
+            _high_water = used;
+        if (_tap)
+            _tap(_tap_context, tail);
+        _tail.store(pos + 1, std::memory_order_release);
+        wake();
+    }
+
+    /// Nonblocking read
+    bool read_nb(__STREAM_T__& head) {
+        size_t pos = _head.load(std::memory_order_relaxed);
+        if (pos == _tail.load(std::memory_order_acquire)) {
+            head = __STREAM_T__();
+            return false;
+        }
+        head = load(pos);
+        _head.store(pos + 1, std::memory_order_release);
+        wake();
+        return true;
+    }
+
+    /// Nonblocking write
+    bool write_nb(const __STREAM_T__& tail) {
+        if (full())
+            return false;
+        write(tail);
+        return true;
+    }
+
+    /// Fifo size
+    size_t size() {
+        return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+    }
+
+  private:
+    size_t capacity() const { return _data ? _mask + 1 : 0; }
+
+    // Most elements the threaded FIFO holds: its depth, or the ring size if the depth grew after allocation
+    size_t bound() const {
+        size_t depth = _depth > 0 ? _depth : 1;
+        return _data && capacity() < depth ? capacity() : depth;
+    }
+
+    // Reallocates the ring with at least slots slots, keeping the elements at their indices
+    void allocate(size_t slots) {
+        size_t n = 1;
+        while (n < slots)
+            n <<= 1;
+        std::unique_ptr<__STREAM_T__[]> data(new __STREAM_T__[n]);
+        size_t head = _head.load(std::memory_order_acquire);
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        for (size_t i = head; i != tail; i++) {
+            data[i & (n - 1)] = _data[i & _mask];
+        }
+        _data.swap(data);
+        _mask = n - 1;
+    }
+
+    // Element at index pos, which holds data
+    __STREAM_T__ load(size_t pos) {
+#ifdef HLS_STREAM_THREAD_SAFE
+        if (!_sized) {
+            // The producer may be growing the ring
+            std::lock_guard<std::mutex> lock(_grow_mutex);
+            return _data[pos & _mask];
+        }
+#endif
+        return _data[pos & _mask];
+    }
+
+    // Waits until slot pos can be written, growing the ring if it is not bounded
+    void make_room(size_t pos) {
+        if (!_data) {
+            allocate(_depth > 0 ? _depth : 1);
+        }
+#ifdef HLS_STREAM_THREAD_SAFE
+        if (_sized) {
+            const size_t depth = bound();
+            if (pos - _head.load(std::memory_order_acquire) < depth)
+                return;
+            wait([&]() { return pos - _head.load(std::memory_order_acquire) < depth; });
+            return;
+        }
+        if (pos - _head.load(std::memory_order_acquire) < capacity())
+            return;
+        std::lock_guard<std::mutex> lock(_grow_mutex);
+        allocate(2 * capacity());
+#else
+        if (pos - _head.load(std::memory_order_acquire) < capacity())
+            return;
+        allocate(2 * capacity());
+#endif
+    }
+
+    // Whether slot pos holds data, waiting for the producer in the threaded model
+    bool wait_for_data(size_t pos) {
+        if (pos != _tail.load(std::memory_order_acquire))
+            return true;
+#ifdef HLS_STREAM_THREAD_SAFE
+        wait([&]() { return pos != _tail.load(std::memory_order_acquire); });
+        return true;
+#else
+        return false;
+#endif
+    }
+
+#ifdef HLS_STREAM_THREAD_SAFE
+    template<class ready_T>
+    void wait(ready_T ready) {
+        // Spinning only pays off if the other side runs on another core
+        static const unsigned spin = std::thread::hardware_concurrency() > 1 ? HLS_STREAM_RING_SPIN : 0;
+        for (unsigned i = 0; i < spin; i++) {
+            if (ready())
+                return;
+            if (i >= spin / 2)
+                std::this_thread::yield();
+        }
+        std::unique_lock<std::mutex> lock(_park_mutex);
+        _parked.fetch_add(1, std::memory_order_seq_cst);
+        // Pairs with the fence in wake(): either ready() sees the other side's update, or wake() sees _parked
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        _park_cv.wait(lock, ready);
+        _parked.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void wake() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_parked.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(_park_mutex);
+            _park_cv.notify_all();
+        }
+#ifdef HLS_STREAM_YIELD
+        // Let the other side run after every transfer, so that data moves on as soon as it is produced
+        std::this_thread::yield();
+#endif
+    }
+#else
+    void wake() {}
+#endif
+};
+
+#else
+
+template<typename __STREAM_T__>
+class stream
+{
+  protected:
+    std::string _name;
+    size_t _depth;
+    size_t _high_water;
+    void (*_tap)(void *, const __STREAM_T__ &);
+    void *_tap_context;
     std::deque<__STREAM_T__> _data; // container for the elements
 #ifdef HLS_STREAM_THREAD_SAFE
     std::mutex _mutex;
@@ -108,7 +437,7 @@ class stream
   public:
     /// Constructors
     // Keep consistent with the synthesis model's constructors
-    stream() {
+    stream() : _depth(0), _high_water(0), _tap(0), _tap_context(0) {
         static unsigned _counter = 1;
         std::stringstream ss;
 #ifndef _MSC_VER
@@ -128,7 +457,7 @@ class stream
         _name += "." + ss.str();
     }
 
-    stream(const std::string name) {
+    stream(const std::string name) : _depth(0), _high_water(0), _tap(0), _tap_context(0) {
     // default constructor,
     // capacity set to predefined maximum
         _name = name;
@@ -137,11 +466,16 @@ class stream
   /// Make copy constructor and assignment operator private
   private:
     stream(const stream< __STREAM_T__ >& chn):
-        _name(chn._name), _data(chn._data) {
+        _name(chn._name), _depth(chn._depth), _high_water(chn._high_water), _tap(chn._tap),
+        _tap_context(chn._tap_context), _data(chn._data) {
     }
 
     stream& operator = (const stream< __STREAM_T__ >& chn) {
         _name = chn._name;
+        _depth = chn._depth;
+        _high_water = chn._high_water;
+        _tap = chn._tap;
+        _tap_context = chn._tap_context;
         _data = chn._data;
         return *this;
     }
@@ -171,6 +505,24 @@ class stream
         }
     }
 
+    /// Depth of the STREAM pragma, the queue itself is unbounded
+    void set_depth(size_t depth) {
+        _depth = depth;
+    }
+
+    size_t depth() const { return _depth; }
+
+    /// Largest number of elements the stream held at once
+    size_t high_water_mark() const { return _high_water; }
+
+    /// Function called with every element written, for tracing in C simulation
+    typedef void (*tap_function)(void *context, const __STREAM_T__ &elem);
+
+    void set_tap(tap_function tap, void *context) {
+        _tap = tap;
+        _tap_context = context;
+    }
+
     /// Status of the queue
     bool empty() {
 #ifdef HLS_STREAM_THREAD_SAFE
@@ -222,8 +574,17 @@ class stream
         std::unique_lock<std::mutex> ul(_mutex);
 #endif
         _data.push_back(tail);
+        if (_data.size() > _high_water)
+            _high_water = _data.size();
+        if (_tap)
+            _tap(_tap_context, tail);
 #ifdef HLS_STREAM_THREAD_SAFE
         _condition_var.notify_one();
+#ifdef HLS_STREAM_YIELD
+        // Let the consumer run after every write, so that data moves on as soon as it is produced
+        ul.unlock();
+        std::this_thread::yield();
+#endif
 #endif
     }
 
@@ -256,6 +617,21 @@ class stream
     }
 };
 
+#endif
+
+// Sets the C simulation depth of a stream or of an array of streams, the counterpart of the STREAM pragma
+template<typename __STREAM_T__>
+void set_depth(stream<__STREAM_T__>& s, size_t depth) {
+    s.set_depth(depth);
+}
+
+template<typename __STREAM_T__, size_t __N__>
+void set_depth(stream<__STREAM_T__> (&s)[__N__], size_t depth) {
+    for (size_t i = 0; i < __N__; i++) {
+        s[i].set_depth(depth);
+    }
+}
+
 } // namespace hls
 
 #endif // __cplusplus
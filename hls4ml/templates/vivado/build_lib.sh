@@ -2,9 +2,21 @@
 
 CC=g++
 if [[ "$OSTYPE" == "linux-gnu" ]]; then
-    CFLAGS="-O3 -fPIC -std=c++11 -fno-gnu-unique"
+    CFLAGS="-O3 -fPIC -std=c++11 -fno-gnu-unique -pthread"
 elif [[ "$OSTYPE" == "darwin"* ]]; then
-    CFLAGS="-O3 -fPIC -std=c++11"
+    CFLAGS="-O3 -fPIC -std=c++11 -pthread"
+fi
+if [[ -n "${HLS4ML_OPENMP}" ]]; then
+    CFLAGS="${CFLAGS} -fopenmp"
+fi
+if [[ -n "${HLS4ML_STREAM_RING_BUFFER}" ]]; then
+    CFLAGS="${CFLAGS} -DHLS_STREAM_RING_BUFFER"
+fi
+if [[ -n "${HLS4ML_DATAFLOW_THREADS}" ]]; then
+    CFLAGS="${CFLAGS} -DNNET_DATAFLOW_THREADS -DHLS_STREAM_THREAD_SAFE"
+fi
+if [[ -n "${HLS4ML_FIFO_DEPTHS}" ]]; then
+    CFLAGS="${CFLAGS} -DNNET_FIFO_DEPTHS -DHLS_STREAM_YIELD"
 fi
 LDFLAGS=
 INCFLAGS="-Ifirmware/ap_types/"
@@ -4,6 +4,7 @@
 array set opt {
   reset      0
   csim       1
+  csim_threads 1
   synth      1
   cosim      1
   validation 1
@@ -73,7 +74,12 @@ create_clock -period 5 -name default
 if {$opt(csim)} {
   puts "***** C SIMULATION *****"
   set time_start [clock clicks -milliseconds]
-  csim_design
+  if {$opt(csim_threads) != 1} {
+    # Parallel testbench, 0 uses all cores
+    csim_design -ldflags "-pthread" -argv "--threads $opt(csim_threads)"
+  } else {
+    csim_design -ldflags "-pthread"
+  }
   set time_end [clock clicks -milliseconds]
   report_time "C SIMULATION" $time_start $time_end
 }
@@ -2,6 +2,7 @@
 
 #include "myproject.h"
 #include "parameters.h"
+#include "nnet_utils/nnet_context.h"
 
 void myproject(
     // hls-fpga-machine-learning insert header
@@ -8,6 +8,8 @@
 #include "nnet_utils/nnet_helpers.h"
 // hls-fpga-machine-learning insert includes
 
+// hls-fpga-machine-learning insert lookup tables
+
 // hls-fpga-machine-learning insert weights
 
 // hls-fpga-machine-learning insert layer-config
@@ -2,6 +2,7 @@
 #define MYPROJECT_BRIDGE_H_
 
 #include "firmware/myproject.h"
+#include "firmware/nnet_utils/nnet_context.h"
 #include "firmware/nnet_utils/nnet_helpers.h"
 #include <algorithm>
 #include <map>
@@ -48,6 +49,12 @@ void collect_trace_output(struct trace_data *c_trace_outputs) {
     }
 }
 
+// Writes the FIFO occupancy profile of a library built with NNET_FIFO_DEPTHS as JSON
+void write_fifo_depths(const char *filename) { nnet::write_fifo_depths(filename); }
+
+// Writes the per-layer profile of a model written for ModelGraph.profile_performance() as JSON
+void write_layer_profile(const char *filename) { nnet::write_layer_profile(filename); }
+
 // Wrapper of top level function for Python bridge
 void myproject_float(
     // hls-fpga-machine-learning insert header #float
@@ -61,6 +68,22 @@ void myproject_double(
 ) {
     // hls-fpga-machine-learning insert wrapper #double
 }
+
+// Batch wrapper: evaluates n_samples samples stored back to back ([n_samples, ...]) in each buffer,
+// spread over n_threads threads (0 = all cores), see nnet::run_batch. A single thread evaluates the
+// samples in order, keeping the state of the layers between them; with more, every sample runs in its
+// own model context.
+void myproject_batch_float(
+    // hls-fpga-machine-learning insert batch header #float
+) {
+    // hls-fpga-machine-learning insert batch wrapper #float
+}
+
+void myproject_batch_double(
+    // hls-fpga-machine-learning insert batch header #double
+) {
+    // hls-fpga-machine-learning insert batch wrapper #double
+}
 }
 
 #endif
@@ -1,13 +1,17 @@
 #include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <map>
 #include <math.h>
+#include <sstream>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string>
 #include <vector>
 
 #include "firmware/myproject.h"
+#include "firmware/nnet_utils/nnet_context.h"
 #include "firmware/nnet_utils/nnet_helpers.h"
 
 // hls-fpga-machine-learning insert bram
@@ -20,6 +24,80 @@ std::map<std::string, void *> *trace_outputs = NULL;
 size_t trace_type_size = sizeof(double);
 } // namespace nnet
 
+#ifndef RTL_SIM
+// Parses the space-separated values of one line, stores at most max_vals of them and returns the count
+static size_t parse_line(const std::string &line, float *dst, size_t max_vals) {
+    const char *pos = line.c_str();
+    char *end;
+    size_t n = 0;
+    for (float val = strtof(pos, &end); end != pos; val = strtof(pos, &end)) {
+        if (n < max_vals)
+            dst[n] = val;
+        n++;
+        pos = end;
+    }
+    return n;
+}
+
+// Evaluates one sample of the parallel testbench and writes its result line to fout
+static void evaluate_sample(const std::vector<float> &in, std::ostream &fout) {
+    // hls-fpga-machine-learning insert data
+
+    // hls-fpga-machine-learning insert top-level-function
+
+    // hls-fpga-machine-learning insert tb-output
+}
+
+// Parallel testbench: the input file is parsed once into a contiguous buffer, the samples are
+// evaluated on n_threads threads (0 = all cores) as in nnet::run_batch, and the results are written
+// in the original order. Per-layer trace files are disabled as their order would be
+// arbitrary.
+static int run_parallel_testbench(std::ifstream &fin, std::ostream &fout, unsigned n_threads) {
+    std::string text((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+
+    size_t n_inputs = parse_line(text.substr(0, text.find('\n')), nullptr, 0);
+    if (n_inputs == 0) {
+        std::cout << "ERROR: No input data in tb_data/tb_input_features.dat" << std::endl;
+        return 1;
+    }
+    size_t n_lines = std::count(text.begin(), text.end(), '\n') + 1;
+    std::vector<float> inputs(n_lines * n_inputs);
+
+    size_t n_samples = 0;
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        size_t n = parse_line(line, &inputs[n_samples * n_inputs], n_inputs);
+        if (n == 0)
+            continue;
+        if (n != n_inputs) {
+            std::cout << "ERROR: Input " << n_samples << " has " << n << " values, expected " << n_inputs << std::endl;
+            return 1;
+        }
+        n_samples++;
+    }
+
+    nnet::trace_enabled = false;
+    std::vector<std::string> results(n_samples);
+    auto start = std::chrono::steady_clock::now();
+    nnet::run_batch(n_samples, n_threads, [&](size_t i) {
+        std::vector<float> in(inputs.begin() + i * n_inputs, inputs.begin() + (i + 1) * n_inputs);
+        std::ostringstream out;
+        evaluate_sample(in, out);
+        results[i] = out.str();
+    });
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (size_t i = 0; i < n_samples; i++) {
+        fout << results[i];
+    }
+    std::cout << "INFO: Evaluated " << n_samples << " inputs in " << elapsed << " s ("
+              << (elapsed > 0 ? n_samples / elapsed : 0) << " inputs/s)" << std::endl;
+
+    return 0;
+}
+#endif
+
 int main(int argc, char **argv) {
     // load input data from text file
     std::ifstream fin("tb_data/tb_input_features.dat");
@@ -33,6 +111,18 @@ int main(int argc, char **argv) {
 #endif
     std::ofstream fout(RESULTS_LOG);
 
+#ifndef RTL_SIM
+    // myproject_test --threads N runs the parallel testbench on N threads (0 = all cores)
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--threads" && fin.is_open()) {
+            int ret = run_parallel_testbench(fin, fout, atoi(argv[i + 1]));
+            fout.close();
+            std::cout << "INFO: Saved inference results to file: " << RESULTS_LOG << std::endl;
+            return ret;
+        }
+    }
+#endif
+
     std::string iline;
     std::string pline;
     int e = 0;
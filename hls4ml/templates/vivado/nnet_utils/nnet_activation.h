@@ -3,6 +3,7 @@
 
 #include "ap_fixed.h"
 #include "nnet_common.h"
+#include "nnet_lut.h"
 #include <cmath>
 
 namespace nnet {
@@ -17,6 +18,7 @@ struct activ_config {
     // Resource reuse info
     static const unsigned io_type = io_parallel;
     static const unsigned reuse_factor = 1;
+    static const unsigned table_ports = 2; // Channels per cycle sharing one table copy, io_array_stream only
 
     // Internal data type definitions
     typedef ap_fixed<18, 8> table_t;
@@ -109,20 +111,26 @@ template <typename CONFIG_T, int N_TABLE> void init_sigmoid_table(typename CONFI
     }
 }
 
+struct sigmoid_lut {
+    template <class table_T, unsigned N_TABLE, class input_T> static void fill(table_T *table) {
+        init_sigmoid_table<lut_config<table_T, N_TABLE>, N_TABLE>(table);
+    }
+};
+
 template <class data_T, class res_T, typename CONFIG_T>
 void sigmoid(data_T data[CONFIG_T::n_in], res_T res[CONFIG_T::n_in]) {
     // Initialize the lookup table
 #ifdef __HLS_SYN__
     bool initialized = false;
     typename CONFIG_T::table_t sigmoid_table[CONFIG_T::table_size];
-#else
-    static bool initialized = false;
-    static typename CONFIG_T::table_t sigmoid_table[CONFIG_T::table_size];
-#endif
     if (!initialized) {
         init_sigmoid_table<CONFIG_T, CONFIG_T::table_size>(sigmoid_table);
         initialized = true;
     }
+#else
+    const typename CONFIG_T::table_t *sigmoid_table =
+        lut_registry<sigmoid_lut, typename CONFIG_T::table_t, CONFIG_T::table_size>::table();
+#endif
 
     #pragma HLS PIPELINE
 
@@ -420,27 +428,34 @@ template <typename CONFIG_T, int N_TABLE> void init_tanh_table(typename CONFIG_T
     for (int ii = 0; ii < N_TABLE; ii++) {
         // First, convert from table index to X-value (signed 8-bit, range -4 to +4)
         float in_val = 2 * 4.0 * (ii - float(N_TABLE) / 2.0) / float(N_TABLE);
-        // Next, compute lookup table function
-        typename CONFIG_T::table_t real_val = tanh(in_val);
+        // Next, compute lookup table function, in double as the tables the writer emits (tanhf differs between
+        // C libraries)
+        typename CONFIG_T::table_t real_val = std::tanh(double(in_val));
         // std::cout << "Tanh:  Lookup table Index: " <<  ii<< " In Value: " << in_val << " Result: " << real_val <<
         // std::endl;
         table_out[ii] = real_val;
     }
 }
 
+struct tanh_lut {
+    template <class table_T, unsigned N_TABLE, class input_T> static void fill(table_T *table) {
+        init_tanh_table<lut_config<table_T, N_TABLE>, N_TABLE>(table);
+    }
+};
+
 template <class data_T, class res_T, typename CONFIG_T> void tanh(data_T data[CONFIG_T::n_in], res_T res[CONFIG_T::n_in]) {
     // Initialize the lookup table
 #ifdef __HLS_SYN__
     bool initialized = false;
     typename CONFIG_T::table_t tanh_table[CONFIG_T::table_size];
-#else
-    static bool initialized = false;
-    static typename CONFIG_T::table_t tanh_table[CONFIG_T::table_size];
-#endif
     if (!initialized) {
         init_tanh_table<CONFIG_T, CONFIG_T::table_size>(tanh_table);
         initialized = true;
     }
+#else
+    const typename CONFIG_T::table_t *tanh_table =
+        lut_registry<tanh_lut, typename CONFIG_T::table_t, CONFIG_T::table_size>::table();
+#endif
 
     #pragma HLS PIPELINE
 
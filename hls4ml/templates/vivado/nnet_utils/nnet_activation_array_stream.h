@@ -30,6 +30,74 @@ void linear(hls::stream<data_T> data[CONFIG_T::n_chan], hls::stream<res_T> res[C
     }
 }
 
+// *************************************************
+//       Sigmoid Activation
+// *************************************************
+
+template<class data_T, class res_T, typename CONFIG_T>
+void sigmoid(hls::stream<data_T> data[CONFIG_T::n_chan], hls::stream<res_T> res[CONFIG_T::n_chan]) {
+    // Initialize the lookup table, shared by table_ports of the channels read in a cycle
+    lut_bank<typename CONFIG_T::table_t, CONFIG_T::n_chan, CONFIG_T::table_size, CONFIG_T::table_ports,
+             CONFIG_T::reuse_factor>
+        sigmoid_table;
+    sigmoid_table.template init<sigmoid_lut, void>();
+
+    static const unsigned chan_per_cycle = DIV_ROUNDUP(CONFIG_T::n_chan, CONFIG_T::reuse_factor);
+
+    SigmoidLoop: for (int i = 0; i < CONFIG_T::n_in / CONFIG_T::n_chan; i++) {
+        SigmoidReuseLoop: for (unsigned r = 0; r < CONFIG_T::reuse_factor; r++) {
+            #pragma HLS PIPELINE II=1
+            for (unsigned k = 0; k < chan_per_cycle; k++) {
+                #pragma HLS UNROLL
+                unsigned j = r * chan_per_cycle + k;
+                if (j >= CONFIG_T::n_chan)
+                    continue;
+                int data_round = data[j].read() * CONFIG_T::table_size / 16;
+                int index = data_round + 8 * CONFIG_T::table_size / 16;
+                if (index < 0)
+                    index = 0;
+                if (index > CONFIG_T::table_size - 1)
+                    index = CONFIG_T::table_size - 1;
+                res[j].write((res_T)sigmoid_table.lookup(k, index));
+            }
+        }
+    }
+}
+
+// *************************************************
+//       TanH Activation
+// *************************************************
+
+template<class data_T, class res_T, typename CONFIG_T>
+void tanh(hls::stream<data_T> data[CONFIG_T::n_chan], hls::stream<res_T> res[CONFIG_T::n_chan]) {
+    // Initialize the lookup table, shared by table_ports of the channels read in a cycle
+    lut_bank<typename CONFIG_T::table_t, CONFIG_T::n_chan, CONFIG_T::table_size, CONFIG_T::table_ports,
+             CONFIG_T::reuse_factor>
+        tanh_table;
+    tanh_table.template init<tanh_lut, void>();
+
+    static const unsigned chan_per_cycle = DIV_ROUNDUP(CONFIG_T::n_chan, CONFIG_T::reuse_factor);
+
+    TanHLoop: for (int i = 0; i < CONFIG_T::n_in / CONFIG_T::n_chan; i++) {
+        TanHReuseLoop: for (unsigned r = 0; r < CONFIG_T::reuse_factor; r++) {
+            #pragma HLS PIPELINE II=1
+            for (unsigned k = 0; k < chan_per_cycle; k++) {
+                #pragma HLS UNROLL
+                unsigned j = r * chan_per_cycle + k;
+                if (j >= CONFIG_T::n_chan)
+                    continue;
+                int data_round = data[j].read() * CONFIG_T::table_size / 8;
+                int index = data_round + 4 * CONFIG_T::table_size / 8;
+                if (index < 0)
+                    index = 0;
+                if (index > CONFIG_T::table_size - 1)
+                    index = CONFIG_T::table_size - 1;
+                res[j].write((res_T)tanh_table.lookup(k, index));
+            }
+        }
+    }
+}
+
 } // namespace nnet
 
 #endif
@@ -67,14 +67,14 @@ template <class data_T, class res_T, typename CONFIG_T> void sigmoid(hls::stream
 #ifdef __HLS_SYN__
     bool initialized = false;
     typename CONFIG_T::table_t sigmoid_table[CONFIG_T::table_size];
-#else
-    static bool initialized = false;
-    static typename CONFIG_T::table_t sigmoid_table[CONFIG_T::table_size];
-#endif
     if (!initialized) {
         init_sigmoid_table<CONFIG_T, CONFIG_T::table_size>(sigmoid_table);
         initialized = true;
     }
+#else
+    const typename CONFIG_T::table_t *sigmoid_table =
+        lut_registry<sigmoid_lut, typename CONFIG_T::table_t, CONFIG_T::table_size>::table();
+#endif
 
 SigmoidActLoop:
     for (int i = 0; i < CONFIG_T::n_in / res_T::size; i++) {
@@ -379,14 +379,14 @@ template <class data_T, class res_T, typename CONFIG_T> void tanh(hls::stream<da
 #ifdef __HLS_SYN__
     bool initialized = false;
     typename CONFIG_T::table_t tanh_table[CONFIG_T::table_size];
-#else
-    static bool initialized = false;
-    static typename CONFIG_T::table_t tanh_table[CONFIG_T::table_size];
-#endif
     if (!initialized) {
         init_tanh_table<CONFIG_T, CONFIG_T::table_size>(tanh_table);
         initialized = true;
     }
+#else
+    const typename CONFIG_T::table_t *tanh_table =
+        lut_registry<tanh_lut, typename CONFIG_T::table_t, CONFIG_T::table_size>::table();
+#endif
 
 TanHActLoop:
     for (int i = 0; i < CONFIG_T::n_in / res_T::size; i++) {
@@ -5,7 +5,18 @@
 #include "nnet_common.h"
 #include "nnet_recurrent.h"
 
+#ifndef __SYNTHESIS__
+#include <thread>
+#endif
+
 namespace nnet{
+
+// sequential: backward GRU starts after the forward GRU is done
+// concurrent: both directions run as DATAFLOW processes (csim: one thread per direction)
+// streaming:  forward GRU consumes timesteps as they arrive, backward GRU reads the single
+//             sequence buffer in reverse, consecutive trials overlap through the ping-pong buffer
+enum class bidirectional_implementation { sequential = 0, concurrent = 1, streaming = 2 };
+
 struct bidirectional_config
 {
     // Internal data type definitions
@@ -27,6 +38,7 @@ struct bidirectional_config
     static const bool store_weights_in_bram = false;
     static const bool use_static = true;
     static const unsigned n_zeros = 0;
+    static const bidirectional_implementation implementation = bidirectional_implementation::sequential;
 
     template<class x_T, class y_T, class config_T>
     using activation_recr = nnet::activation::relu<x_T, y_T, config_T>;
@@ -83,6 +95,217 @@ template<class data_T, class res_T, typename CONFIG_T>
     }
 }
 
+template<class data_T, typename CONFIG_T>
+  void bidirectional_split_input(
+      hls::stream<data_T> data_in[CONFIG_T::n_in],
+      data_T forward_in[CONFIG_T::n_sequence*CONFIG_T::n_in],
+      data_T backward_in[CONFIG_T::n_sequence*CONFIG_T::n_in]
+  ){
+    SplitInput: for (int i=0; i<(CONFIG_T::n_sequence); i++){
+        #pragma HLS PIPELINE
+        for(int j=0; j<(CONFIG_T::n_in); j++){
+            #pragma HLS UNROLL
+            data_T temp = data_in[j].read();
+            forward_in[(i*(CONFIG_T::n_in))+j] = temp;
+            backward_in[(CONFIG_T::n_sequence-(i+1))*(CONFIG_T::n_in) + j] = temp;
+        }
+    }
+}
+
+template<class res_T, typename CONFIG_T>
+  void bidirectional_concat_output(
+      res_T forward_out[CONFIG_T::n_sequence_out*CONFIG_T::n_state],
+      res_T backward_out[CONFIG_T::n_sequence_out*CONFIG_T::n_state],
+      hls::stream<res_T> data_out[CONFIG_T::n_out]
+  ){
+    ConcatOutput: for(int j=0; j<(CONFIG_T::n_out); j++){
+        #pragma HLS UNROLL
+        res_T out_tmpt;
+        if(j <CONFIG_T::n_state ){
+            out_tmpt = forward_out[(CONFIG_T::n_sequence_out-1)* (CONFIG_T::n_state)+j];
+        }
+        else {
+            out_tmpt = backward_out[(CONFIG_T::n_sequence_out-1)* (CONFIG_T::n_state)+j-(CONFIG_T::n_state)];
+        }
+        data_out[j].write(out_tmpt);
+    }
+}
+
+// Forward and backward GRU are independent, so they run side by side as DATAFLOW processes.
+// Each direction owns its input buffer, so the two processes never share a memory port.
+template<class data_T, class res_T, typename CONFIG_T>
+  void bidirectional_array_concurrent(
+      hls::stream<data_T> data_in[CONFIG_T::n_in],
+      hls::stream<res_T> data_out[CONFIG_T::n_out],
+      typename CONFIG_T::weight_t     bweight     [CONFIG_T::n_state*3*CONFIG_T::n_in],
+      typename CONFIG_T::weight_t     brecweight  [CONFIG_T::n_state*3*CONFIG_T::n_state],
+      typename CONFIG_T::bias_t       bbais       [CONFIG_T::n_state*3],
+      typename CONFIG_T::bias_t       bbias_r     [CONFIG_T::n_state*3],
+      typename CONFIG_T::weight_t     fweight     [CONFIG_T::n_state*3*CONFIG_T::n_in],
+      typename CONFIG_T::weight_t     frecweight  [CONFIG_T::n_state*3*CONFIG_T::n_state],
+      typename CONFIG_T::bias_t       fbias       [CONFIG_T::n_state*3],
+      typename CONFIG_T::bias_t       fbias_r     [CONFIG_T::n_state*3]
+  ){
+    #pragma HLS DATAFLOW
+
+    data_T forward_in[CONFIG_T::n_sequence*CONFIG_T::n_in];
+    #pragma HLS ARRAY_PARTITION variable=forward_in cyclic factor=CONFIG_T::n_in
+    data_T backward_in[CONFIG_T::n_sequence*CONFIG_T::n_in];
+    #pragma HLS ARRAY_PARTITION variable=backward_in cyclic factor=CONFIG_T::n_in
+
+    res_T forwardgru_out[CONFIG_T::n_sequence_out*CONFIG_T::n_state];
+    #pragma HLS ARRAY_PARTITION variable=forwardgru_out cyclic factor=CONFIG_T::n_state
+    res_T backwardgru_out[CONFIG_T::n_sequence_out*CONFIG_T::n_state];
+    #pragma HLS ARRAY_PARTITION variable=backwardgru_out cyclic factor=CONFIG_T::n_state
+
+    nnet::bidirectional_split_input<data_T, CONFIG_T>(data_in, forward_in, backward_in);
+
+#ifndef __SYNTHESIS__
+    // The two directions are separate template instances, so their GRU states do not collide.
+    // The backward thread uses the model context of the caller.
+    model_context *ctx = &current_context();
+    std::thread backward_thread([&]() {
+        context_scope scope(ctx);
+        nnet::gru_stack_for_bidirectional<data_T, res_T, typename CONFIG_T::config_rnn_layer_b>(
+            backward_in, backwardgru_out, bweight, brecweight, bbais, bbias_r);
+    });
+    nnet::gru_stack_for_bidirectional<data_T, res_T, typename CONFIG_T::config_rnn_layer_f>(forward_in, forwardgru_out, fweight, frecweight, fbias, fbias_r);
+    backward_thread.join();
+#else
+    nnet::gru_stack_for_bidirectional<data_T, res_T, typename CONFIG_T::config_rnn_layer_f>(forward_in, forwardgru_out, fweight, frecweight, fbias, fbias_r);
+    nnet::gru_stack_for_bidirectional<data_T, res_T, typename CONFIG_T::config_rnn_layer_b>(backward_in, backwardgru_out, bweight, brecweight, bbais, bbias_r);
+#endif
+
+    nnet::bidirectional_concat_output<res_T, CONFIG_T>(forwardgru_out, backwardgru_out, data_out);
+}
+
+// Forward direction of the streaming implementation: each timestep is fed to the GRU as soon as
+// it is read and is also stored in seq_buffer for the backward direction.
+template<class data_T, class res_T, typename CONFIG_T>
+  void bidirectional_forward_stream(
+      hls::stream<data_T> data_in[CONFIG_T::n_in],
+      data_T seq_buffer[CONFIG_T::n_sequence*CONFIG_T::n_in],
+      res_T  forward_out[CONFIG_T::n_state],
+      typename CONFIG_T::weight_t     fweight     [CONFIG_T::n_state*3*CONFIG_T::n_in],
+      typename CONFIG_T::weight_t     frecweight  [CONFIG_T::n_state*3*CONFIG_T::n_state],
+      typename CONFIG_T::bias_t       fbias       [CONFIG_T::n_state*3],
+      typename CONFIG_T::bias_t       fbias_r     [CONFIG_T::n_state*3]
+  ){
+    typedef typename CONFIG_T::config_rnn_layer_f config_f;
+
+    res_T h_newstate[CONFIG_T::n_state];
+    #pragma HLS ARRAY_PARTITION variable=h_newstate complete
+    for(int ii = 0; ii < CONFIG_T::n_state; ii++) {
+        #pragma HLS UNROLL
+        h_newstate[ii] = 0;
+    }
+
+    data_T data_step[CONFIG_T::n_in];
+    #pragma HLS ARRAY_PARTITION variable=data_step complete
+    bool reset_state = true;
+
+    ForwardSequence: for (int i=0; i<(CONFIG_T::n_sequence); i++){
+        for(int j=0; j<(CONFIG_T::n_in); j++){
+            #pragma HLS UNROLL
+            data_T temp = data_in[j].read();
+            data_step[j] = temp;
+            seq_buffer[(i*(CONFIG_T::n_in))+j] = temp;
+        }
+        if (config_f::use_static)
+            nnet::gru_static<data_T, res_T, config_f>(reset_state, data_step, h_newstate, fweight, frecweight, fbias, fbias_r);
+        else
+            nnet::gru<data_T, res_T, config_f>(reset_state, data_step, h_newstate, fweight, frecweight, fbias, fbias_r);
+        reset_state = false;
+    }
+
+    for(int ii = 0; ii < CONFIG_T::n_state; ii++) {
+        #pragma HLS UNROLL
+        forward_out[ii] = h_newstate[ii];
+    }
+}
+
+// Backward direction of the streaming implementation: walks seq_buffer from the last timestep
+// to the first, so no reversed copy of the input is needed.
+template<class data_T, class res_T, typename CONFIG_T>
+  void bidirectional_backward_buffer(
+      data_T seq_buffer[CONFIG_T::n_sequence*CONFIG_T::n_in],
+      res_T  backward_out[CONFIG_T::n_state],
+      typename CONFIG_T::weight_t     bweight     [CONFIG_T::n_state*3*CONFIG_T::n_in],
+      typename CONFIG_T::weight_t     brecweight  [CONFIG_T::n_state*3*CONFIG_T::n_state],
+      typename CONFIG_T::bias_t       bbais       [CONFIG_T::n_state*3],
+      typename CONFIG_T::bias_t       bbias_r     [CONFIG_T::n_state*3]
+  ){
+    typedef typename CONFIG_T::config_rnn_layer_b config_b;
+
+    res_T h_newstate[CONFIG_T::n_state];
+    #pragma HLS ARRAY_PARTITION variable=h_newstate complete
+    for(int ii = 0; ii < CONFIG_T::n_state; ii++) {
+        #pragma HLS UNROLL
+        h_newstate[ii] = 0;
+    }
+
+    data_T data_step[CONFIG_T::n_in];
+    #pragma HLS ARRAY_PARTITION variable=data_step complete
+    bool reset_state = true;
+
+    BackwardSequence: for (int i=0; i<(CONFIG_T::n_sequence); i++){
+        for(int j=0; j<(CONFIG_T::n_in); j++){
+            #pragma HLS UNROLL
+            data_step[j] = seq_buffer[(CONFIG_T::n_sequence-(i+1))*(CONFIG_T::n_in) + j];
+        }
+        if (config_b::use_static)
+            nnet::gru_static<data_T, res_T, config_b>(reset_state, data_step, h_newstate, bweight, brecweight, bbais, bbias_r);
+        else
+            nnet::gru<data_T, res_T, config_b>(reset_state, data_step, h_newstate, bweight, brecweight, bbais, bbias_r);
+        reset_state = false;
+    }
+
+    for(int ii = 0; ii < CONFIG_T::n_state; ii++) {
+        #pragma HLS UNROLL
+        backward_out[ii] = h_newstate[ii];
+    }
+}
+
+// Only one copy of the sequence is kept. seq_buffer has a single producer (forward) and a single
+// consumer (backward), so DATAFLOW turns it into a ping-pong buffer: while the backward GRU drains
+// trial k, the forward GRU of trial k+1 already fills the other bank.
+template<class data_T, class res_T, typename CONFIG_T>
+  void bidirectional_array_streaming(
+      hls::stream<data_T> data_in[CONFIG_T::n_in],
+      hls::stream<res_T> data_out[CONFIG_T::n_out],
+      typename CONFIG_T::weight_t     bweight     [CONFIG_T::n_state*3*CONFIG_T::n_in],
+      typename CONFIG_T::weight_t     brecweight  [CONFIG_T::n_state*3*CONFIG_T::n_state],
+      typename CONFIG_T::bias_t       bbais       [CONFIG_T::n_state*3],
+      typename CONFIG_T::bias_t       bbias_r     [CONFIG_T::n_state*3],
+      typename CONFIG_T::weight_t     fweight     [CONFIG_T::n_state*3*CONFIG_T::n_in],
+      typename CONFIG_T::weight_t     frecweight  [CONFIG_T::n_state*3*CONFIG_T::n_state],
+      typename CONFIG_T::bias_t       fbias       [CONFIG_T::n_state*3],
+      typename CONFIG_T::bias_t       fbias_r     [CONFIG_T::n_state*3]
+  ){
+    #pragma HLS DATAFLOW
+
+    data_T seq_buffer[CONFIG_T::n_sequence*CONFIG_T::n_in];
+    #pragma HLS ARRAY_PARTITION variable=seq_buffer cyclic factor=CONFIG_T::n_in
+
+    res_T forward_out[CONFIG_T::n_state];
+    #pragma HLS ARRAY_PARTITION variable=forward_out complete
+    res_T backward_out[CONFIG_T::n_state];
+    #pragma HLS ARRAY_PARTITION variable=backward_out complete
+
+    nnet::bidirectional_forward_stream<data_T, res_T, CONFIG_T>(data_in, seq_buffer, forward_out, fweight, frecweight, fbias, fbias_r);
+    nnet::bidirectional_backward_buffer<data_T, res_T, CONFIG_T>(seq_buffer, backward_out, bweight, brecweight, bbais, bbias_r);
+
+    ConcatOutput: for(int j=0; j<(CONFIG_T::n_out); j++){
+        #pragma HLS UNROLL
+        if(j <CONFIG_T::n_state ){
+            data_out[j].write(forward_out[j]);
+        }
+        else {
+            data_out[j].write(backward_out[j-(CONFIG_T::n_state)]);
+        }
+    }
+}
+
 template<class data_T, class res_T, typename CONFIG_T>
   void bidirectional_array(
       hls::stream<data_T> data_in[CONFIG_T::n_in],
@@ -97,6 +320,14 @@ template<class data_T, class res_T, typename CONFIG_T>
       typename CONFIG_T::bias_t       fbias_r     [CONFIG_T::n_state*3]
   ){
 
+    if (CONFIG_T::implementation == bidirectional_implementation::concurrent) {
+        nnet::bidirectional_array_concurrent<data_T, res_T, CONFIG_T>(data_in, data_out, bweight, brecweight, bbais, bbias_r, fweight, frecweight, fbias, fbias_r);
+        return;
+    }
+    if (CONFIG_T::implementation == bidirectional_implementation::streaming) {
+        nnet::bidirectional_array_streaming<data_T, res_T, CONFIG_T>(data_in, data_out, bweight, brecweight, bbais, bbias_r, fweight, frecweight, fbias, fbias_r);
+        return;
+    }
 
     data_T temp_normal[CONFIG_T::n_sequence*CONFIG_T::n_in];
     #pragma HLS ARRAY_PARTITION variable=temp_normal cyclic factor=CONFIG_T::n_in
@@ -137,4 +368,4 @@ template<class data_T, class res_T, typename CONFIG_T>
 }
 
   }
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
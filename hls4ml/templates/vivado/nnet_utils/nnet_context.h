@@ -0,0 +1,191 @@
+#ifndef NNET_CONTEXT_H_
+#define NNET_CONTEXT_H_
+
+#ifndef __SYNTHESIS__
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <typeindex>
+#include <typeinfo>
+#include <vector>
+#endif
+
+namespace nnet {
+
+#ifndef __SYNTHESIS__
+
+// Owner of the state that layers keep between calls in hardware (e.g. the GRU/LSTM hidden state).
+// In C simulation that state is looked up in the context bound to the calling thread instead of a
+// function-local static, so several threads can evaluate the model at the same time.
+class model_context {
+  public:
+    explicit model_context(size_t sample_index = 0) : id_(next_id()), sample_index_(sample_index) {}
+    model_context(const model_context &) = delete;
+    model_context &operator=(const model_context &) = delete;
+
+    // The directions of a concurrent bidirectional layer share one context, hence the lock
+    template <class state_T> state_T &state() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::shared_ptr<void> &slot = slots_[std::type_index(typeid(state_T))];
+        if (!slot) {
+            slot = std::make_shared<state_T>();
+        }
+        return *static_cast<state_T *>(slot.get());
+    }
+
+    unsigned long id() const { return id_; }
+
+    // Position of the sample in a batch run, lets stateful layers such as random number generators
+    // derive a per-sample state that does not depend on which thread evaluates the sample
+    size_t sample_index() const { return sample_index_; }
+
+  private:
+    static unsigned long next_id() {
+        static std::atomic<unsigned long> counter(0);
+        return ++counter;
+    }
+
+    unsigned long id_;
+    size_t sample_index_;
+    std::mutex mutex_;
+    std::map<std::type_index, std::shared_ptr<void>> slots_;
+};
+
+inline model_context *&bound_context() {
+    static thread_local model_context *ctx = nullptr;
+    return ctx;
+}
+
+// Context bound to the calling thread, or the thread's own default context if none is bound
+inline model_context &current_context() {
+    static thread_local model_context default_ctx;
+    model_context *ctx = bound_context();
+    return ctx ? *ctx : default_ctx;
+}
+
+// Binds a caller-supplied context to the calling thread for the lifetime of the scope
+class context_scope {
+  public:
+    explicit context_scope(model_context *ctx) : prev_(bound_context()) { bound_context() = ctx; }
+    ~context_scope() { bound_context() = prev_; }
+
+  private:
+    model_context *prev_;
+};
+
+template <class state_T> state_T &context_state() {
+    // Layers ask for the same state on every timestep, so remember the last lookup
+    static thread_local unsigned long cached_id = 0;
+    static thread_local state_T *cached_state = nullptr;
+    model_context &ctx = current_context();
+    if (cached_id != ctx.id()) {
+        cached_state = &ctx.state<state_T>();
+        cached_id = ctx.id();
+    }
+    return *cached_state;
+}
+
+// Evaluates sample_fn(i) for i in [0, n_samples) on n_threads threads (0 = all cores).
+// With n_threads == 1 the samples run in order in the caller's context, as separate calls of the top
+// function would: state kept between calls (e.g. a GRU stack with reset_state=false, the sampling
+// random number generators) carries over from one sample to the next.
+// Otherwise every sample gets a fresh context, so the result does not depend on the thread count or
+// sample order. The first sample runs alone on the calling thread to do the one-time weight loading
+// and table setup. When built with OpenMP the remaining samples are spread by an OpenMP loop instead
+// of std::thread.
+template <class sample_fn_T> void run_batch(size_t n_samples, unsigned n_threads, sample_fn_T sample_fn) {
+    if (n_samples == 0) {
+        return;
+    }
+    if (n_threads == 1) {
+        for (size_t i = 0; i < n_samples; i++) {
+            sample_fn(i);
+        }
+        return;
+    }
+    if (n_threads == 0) {
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    {
+        model_context ctx(0);
+        context_scope scope(&ctx);
+        sample_fn(0);
+    }
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic) num_threads(n_threads)
+    for (long i = 1; i < (long)n_samples; i++) {
+        model_context ctx((size_t)i);
+        context_scope scope(&ctx);
+        sample_fn((size_t)i);
+    }
+#else
+    std::atomic<size_t> next_sample(1);
+    auto worker = [&]() {
+        for (size_t i = next_sample++; i < n_samples; i = next_sample++) {
+            model_context ctx(i);
+            context_scope scope(&ctx);
+            sample_fn(i);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < std::min<size_t>(n_threads, n_samples); t++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto &t : pool) {
+        t.join();
+    }
+#endif
+}
+
+// Runs the processes of a DATAFLOW region concurrently, one thread per process, the way they overlap
+// in hardware. The processes only talk through hls::stream objects, built with HLS_STREAM_THREAD_SAFE
+// so that a read blocks until the producer has written. Every thread works in the caller's context.
+// join() must be called before the streams the processes use go out of scope.
+class dataflow_region {
+  public:
+    dataflow_region() : ctx_(&current_context()) {}
+    dataflow_region(const dataflow_region &) = delete;
+    dataflow_region &operator=(const dataflow_region &) = delete;
+    ~dataflow_region() { join(); }
+
+    template <class process_T> void spawn(process_T process) {
+        model_context *ctx = ctx_;
+        threads_.emplace_back([ctx, process]() {
+            context_scope scope(ctx);
+            process();
+        });
+    }
+
+    void join() {
+        for (auto &t : threads_) {
+            t.join();
+        }
+        threads_.clear();
+    }
+
+  private:
+    model_context *ctx_;
+    std::vector<std::thread> threads_;
+};
+
+#endif
+
+// Layer call of a DATAFLOW region in the top function. With NNET_DATAFLOW_THREADS (C simulation only)
+// the call runs on its own thread of the region, otherwise it is an ordinary call.
+#if defined(NNET_DATAFLOW_THREADS) && !defined(__SYNTHESIS__)
+#define NNET_DATAFLOW_PROCESS(region, ...) region.spawn([&]() { __VA_ARGS__; })
+#else
+#define NNET_DATAFLOW_PROCESS(region, ...) __VA_ARGS__
+#endif
+
+} // namespace nnet
+
+#endif
@@ -1,7 +1,11 @@
 #ifndef NNET_DENSE_ARRAY_STREAM_H_
 #define NNET_DENSE_ARRAY_STREAM_H_
 
+#include "nnet_activation.h"
 #include "nnet_common.h"
+#include "nnet_dense.h"
+#include "nnet_exp_range_reduced.h"
+#include "nnet_lut.h"
 #include "nnet_types.h"
 #include "hls_stream.h"
 #include <math.h>
@@ -54,6 +58,134 @@ void dense(
     }
 }
 
+// *************************************************
+//       Dense + Activation
+// *************************************************
+
+enum class fused_activation { relu = 0, sigmoid = 1, tanh = 2, exp = 3 };
+
+struct dense_activation_config : dense_config {
+    static const fused_activation activation = fused_activation::relu;
+    // Type of the dense result before the activation
+    typedef ap_fixed<16, 6> dense_res_t;
+
+    // Lookup table of sigmoid and tanh, see lut_bank
+    static const unsigned table_size = 1024;
+    static const unsigned table_ports = 2;
+    typedef ap_fixed<18, 8> table_t;
+
+    // exp is range reduced, see nnet_exp_range_reduced.h: there is no standalone exp activation to share a table
+    // with, and the direct tables of softmax and explogvar are coarser (up to 0.8% relative error, against about
+    // 1e-4 here), so the fused exp does not match them bit for bit
+    static const unsigned mant_table_size = 32;
+    typedef ap_ufixed<18, 1> mant_table_t;
+};
+
+template<class data_T, class res_T, typename CONFIG_T, class table_T>
+res_T fused_activation_lane(data_T x, const table_T &table, unsigned k) {
+    #pragma HLS INLINE
+    if (CONFIG_T::activation == fused_activation::relu) {
+        if (x > 0)
+            return x;
+        return 0;
+    }
+
+    if (CONFIG_T::activation == fused_activation::exp) {
+        // exp(x) = exp(0.5 * 2x), one more integer bit holds 2x exactly
+        ap_fixed<data_T::width + 1, data_T::iwidth + 1> x2 = x;
+        x2 <<= 1;
+        return exp_half_range_reduced<ap_fixed<data_T::width + 1, data_T::iwidth + 1>, res_T, CONFIG_T>(x2);
+    }
+
+    // Same indexing as the sigmoid (-8 to 8) and tanh (-4 to 4) kernels
+    const int range = (CONFIG_T::activation == fused_activation::sigmoid) ? 16 : 8;
+    int data_round = x * CONFIG_T::table_size / range;
+    int index = data_round + (range / 2) * CONFIG_T::table_size / range;
+    if (index < 0)
+        index = 0;
+    if (index > CONFIG_T::table_size - 1)
+        index = CONFIG_T::table_size - 1;
+    return (res_T)table.lookup(k, index);
+}
+
+template<class data_T, class res_T, typename CONFIG_T>
+void dense_activation(
+    hls::stream<data_T> data_stream[CONFIG_T::n_in],
+    hls::stream<res_T>  res_stream[CONFIG_T::n_out],
+    typename CONFIG_T::weight_t weights[CONFIG_T::n_in*CONFIG_T::n_out],
+    typename CONFIG_T::bias_t   biases[CONFIG_T::n_out])
+{
+    typedef typename CONFIG_T::dense_res_t dense_res_T;
+
+    // Initialize the lookup table, shared by table_ports of the outputs written in a cycle
+    lut_bank<typename CONFIG_T::table_t, CONFIG_T::n_out, CONFIG_T::table_size, CONFIG_T::table_ports,
+             CONFIG_T::reuse_factor>
+        activ_table;
+    if (CONFIG_T::activation == fused_activation::sigmoid) {
+        activ_table.template init<sigmoid_lut, void>();
+    } else if (CONFIG_T::activation == fused_activation::tanh) {
+        activ_table.template init<tanh_lut, void>();
+    }
+
+    data_T data[CONFIG_T::n_in];
+    #pragma HLS ARRAY_PARTITION variable=data complete
+
+    dense_res_T res[CONFIG_T::n_out];
+    #pragma HLS ARRAY_PARTITION variable=res complete
+
+    Data: for (int i = 0; i < CONFIG_T::n_in; i++) {
+        #pragma HLS UNROLL
+        data[i] = data_stream[i].read();
+    }
+
+    dense_wrapper<data_T, dense_res_T, CONFIG_T>(data, res, weights, biases);
+
+    // The activation is applied on the way out, without a stream per output in between
+    static const unsigned outs_per_cycle = DIV_ROUNDUP(CONFIG_T::n_out, CONFIG_T::reuse_factor);
+
+    ResActivReuseLoop: for (unsigned r = 0; r < CONFIG_T::reuse_factor; r++) {
+        #pragma HLS PIPELINE II=1
+        ResActivLoop: for (unsigned k = 0; k < outs_per_cycle; k++) {
+            #pragma HLS UNROLL
+            unsigned i = r * outs_per_cycle + k;
+            if (i >= CONFIG_T::n_out)
+                continue;
+            res_stream[i].write(fused_activation_lane<dense_res_T, res_T, CONFIG_T>(res[i], activ_table, k));
+        }
+    }
+}
+
+// *************************************************
+//       Time-distributed Dense
+// *************************************************
+
+struct time_distributed_dense_config : dense_config {
+    static const unsigned n_sequence = 1;
+    // Initiation interval of the timestep loop, at least reuse_factor
+    static const unsigned sequence_ii = 1;
+};
+
+template<class data_T, class res_T, typename CONFIG_T>
+void time_distributed_dense(
+    hls::stream<data_T> data_stream[CONFIG_T::n_in],
+    hls::stream<res_T>  res_stream[CONFIG_T::n_out],
+    typename CONFIG_T::weight_t weights[CONFIG_T::n_in*CONFIG_T::n_out],
+    typename CONFIG_T::bias_t   biases[CONFIG_T::n_out])
+{
+    // The same weights are applied at every timestep, so they stay resident while the sequence streams through
+    if (CONFIG_T::strategy == nnet::latency) {
+        LatencySequenceLoop: for (unsigned t = 0; t < CONFIG_T::n_sequence; t++) {
+            #pragma HLS PIPELINE II=CONFIG_T::sequence_ii
+            dense<data_T, res_T, CONFIG_T>(data_stream, res_stream, weights, biases);
+        }
+    } else {
+        // dense_resource pipelines its own reuse loop, timesteps follow each other
+        ResourceSequenceLoop: for (unsigned t = 0; t < CONFIG_T::n_sequence; t++) {
+            dense<data_T, res_T, CONFIG_T>(data_stream, res_stream, weights, biases);
+        }
+    }
+}
+
 
 }
 
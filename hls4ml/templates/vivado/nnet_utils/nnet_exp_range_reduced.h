@@ -0,0 +1,100 @@
+#ifndef NNET_EXP_RANGE_REDUCED_H_
+#define NNET_EXP_RANGE_REDUCED_H_
+
+#include "ap_fixed.h"
+#include "nnet_common.h"
+#include "nnet_lut.h"
+#include <cmath>
+
+namespace nnet {
+
+// *************************************************
+//       Range-reduced exp(0.5 * x)
+// *************************************************
+// exp(0.5 * x) = 2^y with y = x * log2(e) / 2, split as y = k + f with k = floor(y) and 0 <= f < 1. 2^f is
+// interpolated linearly between mant_table_size samples of [1, 2), and 2^k is a shift. Per lane this is a
+// constant multiply, one 18 x (24 - log2(mant_table_size)) multiply for the interpolation (1 DSP) and a barrel
+// shifter; the two tables hold 2 * mant_table_size entries instead of the table_size entries of the direct table
+// (64 instead of 1024 by default, 16x less memory).
+//
+// Relative error bounds before the rounding to the result type:
+//  - interpolation: (ln 2)^2 / (8 * mant_table_size^2), 5.9e-5 for 32 entries, 1.5e-5 for 64
+//  - table entries and the interpolation product: 2^-17 + 2^-18 = 1.1e-5 with the default ap_ufixed<18, 1>
+//  - argument: ln 2 * (2^-24 + |x| * 2^-25) from the fractional bits of y and the log2(e) / 2 constant
+// For comparison, the direct table addressed by the top N = log2(table_size) bits of an input with I integer bits
+// has steps of 2^(I - N) in x, so a relative error of up to 0.5 * 2^(I - N), 0.8% for ap_fixed<16, 4> and 1024
+// entries. y saturates at +-128 (|x| >= 177), results beyond 2^24 saturate, below 2^-24 flush to zero.
+
+enum class explogvar_impl { table = 0, range_reduced = 1 };
+
+template <typename CONFIG_T> void init_exp2_mantissa_table(typename CONFIG_T::table_t table_out[CONFIG_T::table_size]) {
+    for (unsigned i = 0; i < CONFIG_T::table_size; i++) {
+        table_out[i] = std::pow(2., double(i) / CONFIG_T::table_size);
+    }
+}
+
+template <typename CONFIG_T> void init_exp2_slope_table(typename CONFIG_T::table_t table_out[CONFIG_T::table_size]) {
+    // Differences of the rounded samples, so the interpolation meets the next sample exactly
+    for (unsigned i = 0; i < CONFIG_T::table_size; i++) {
+        typename CONFIG_T::table_t lo = std::pow(2., double(i) / CONFIG_T::table_size);
+        typename CONFIG_T::table_t hi = std::pow(2., double(i + 1) / CONFIG_T::table_size);
+        table_out[i] = hi - lo;
+    }
+}
+
+struct exp2_mantissa_lut {
+    template <class table_T, unsigned N_TABLE, class input_T> static void fill(table_T *table) {
+        init_exp2_mantissa_table<lut_config<table_T, N_TABLE>>(table);
+    }
+};
+
+struct exp2_slope_lut {
+    template <class table_T, unsigned N_TABLE, class input_T> static void fill(table_T *table) {
+        init_exp2_slope_table<lut_config<table_T, N_TABLE>>(table);
+    }
+};
+
+template <class data_T, class res_T, typename CONFIG_T> res_T exp_half_range_reduced(data_T x) {
+    typedef typename CONFIG_T::mant_table_t mant_table_t;
+#ifdef __HLS_SYN__
+    bool initialized = false;
+    mant_table_t mant_table[CONFIG_T::mant_table_size];
+    mant_table_t slope_table[CONFIG_T::mant_table_size];
+    if (!initialized) {
+        init_exp2_mantissa_table<lut_config<mant_table_t, CONFIG_T::mant_table_size>>(mant_table);
+        init_exp2_slope_table<lut_config<mant_table_t, CONFIG_T::mant_table_size>>(slope_table);
+        initialized = true;
+    }
+#else
+    const mant_table_t *mant_table = lut_registry<exp2_mantissa_lut, mant_table_t, CONFIG_T::mant_table_size>::table();
+    const mant_table_t *slope_table = lut_registry<exp2_slope_lut, mant_table_t, CONFIG_T::mant_table_size>::table();
+#endif
+    static constexpr int M = ceillog2(CONFIG_T::mant_table_size);
+
+    static const ap_ufixed<24, 0> log2e_half = 0.72134752044448170368;
+    ap_fixed<32, 8, AP_TRN, AP_SAT> y = x * log2e_half;
+
+    // floor(y) and the fraction, read straight from the two's complement bits
+    ap_int<8> k = y.range(31, 24);
+    ap_uint<M> i = y.range(23, 24 - M);
+    ap_ufixed<24 - M, 0> r;
+    r.range(23 - M, 0) = y.range(23 - M, 0);
+
+    mant_table_t mant = mant_table[i] + slope_table[i] * r;
+
+    ap_ufixed<48, 24> result = mant;
+    if (k > 23) {
+        result.range(47, 0) = -1;
+    } else if (k < -24) {
+        result = 0;
+    } else if (k >= 0) {
+        result <<= int(k);
+    } else {
+        result >>= int(-k);
+    }
+    return result;
+}
+
+} // namespace nnet
+
+#endif
@@ -5,6 +5,8 @@
 #include "ap_fixed.h"
 #include "hls_stream.h"
 #include "nnet_common.h"
+#include "nnet_exp_range_reduced.h"
+#include "nnet_lut.h"
 #include "nnet_stream.h"
 #include "nnet_types.h"
 #include <cmath>
@@ -47,28 +49,60 @@ void init_explogvar_table(typename CONFIG_T::exp_table_t table_out[CONFIG_T::tab
     }
 }
 
+struct explogvar_lut {
+    template <class table_T, unsigned N_TABLE, class input_T> static void fill(table_T *table) {
+        init_explogvar_table<input_T, lut_config<table_T, N_TABLE>>(table);
+    }
+};
+
 struct explogvar_config {
     static const unsigned n_elem = 32;
     static const unsigned table_size = 1024;
     typedef ap_fixed<18, 8> exp_table_t;
+
+    // Direct table, or the interpolated range reduction of nnet_exp_range_reduced.h
+    static const explogvar_impl exp_impl = explogvar_impl::table;
+    static const unsigned mant_table_size = 32;
+    typedef ap_ufixed<18, 1> mant_table_t;
+
+    // Table banking for the array-stream version, see lut_bank
+    static const unsigned reuse_factor = 1;
+    static const unsigned table_ports = 2;
+};
+
+// exp(0.5 * x) for N_LANES lanes read as in lut_bank, with the implementation chosen by CONFIG_T::exp_impl. Only the
+// direct table holds (and fills) the banks of table_size entries, the range reduction has its own small tables.
+template <class input_T, typename CONFIG_T, unsigned N_LANES, unsigned REUSE, explogvar_impl IMPL = CONFIG_T::exp_impl>
+class explogvar_exp_bank {
+  public:
+    void init() { exp_table.template init<explogvar_lut, input_T>(); }
+
+    typename CONFIG_T::exp_table_t lookup(unsigned k, input_T x) const {
+        #pragma HLS INLINE
+        return exp_table.lookup(k, explogvar_idx_from_real_val<input_T, CONFIG_T>(x));
+    }
+
+  private:
+    lut_bank<typename CONFIG_T::exp_table_t, N_LANES, CONFIG_T::table_size, CONFIG_T::table_ports, REUSE> exp_table;
+};
+
+template <class input_T, typename CONFIG_T, unsigned N_LANES, unsigned REUSE>
+class explogvar_exp_bank<input_T, CONFIG_T, N_LANES, REUSE, explogvar_impl::range_reduced> {
+  public:
+    void init() {}
+
+    typename CONFIG_T::exp_table_t lookup(unsigned k, input_T x) const {
+        #pragma HLS INLINE
+        return exp_half_range_reduced<input_T, typename CONFIG_T::exp_table_t, CONFIG_T>(x);
+    }
 };
 
 template <class data_T, class res_T, typename CONFIG_T>
 void explogvar(hls::stream<data_T> &data, hls::stream<res_T> &res) {
-    // Initialize the lookup tables
-#ifdef __HLS_SYN__
-    bool initialized = false;
-    typename CONFIG_T::exp_table_t exp_table[CONFIG_T::table_size];
-#else
-    static bool initialized = false;
-    static typename CONFIG_T::exp_table_t exp_table[CONFIG_T::table_size];
-
-#endif
-    if (!initialized) {
-        // Note we are exponentiating the inputs, which have type data_T
-        init_explogvar_table<typename data_T::value_type, CONFIG_T>(exp_table);
-        initialized = true;
-    }
+    // Initialize the lookup table, if any, shared by table_ports of the lanes of a pack
+    // Note we are exponentiating the inputs, which have type data_T
+    explogvar_exp_bank<typename data_T::value_type, CONFIG_T, res_T::size, 1> exp_table;
+    exp_table.init();
 
 
 	
@@ -85,8 +119,7 @@ ExpLogVarExpLoop:
 		ExpLogVarExpPackLoop:
         for (unsigned j = 0; j < res_T::size; j++) {
             #pragma HLS UNROLL
-            unsigned x = explogvar_idx_from_real_val<typename data_T::value_type, CONFIG_T>(in_pack[j]);
-            out_pack[j] = exp_table[x];
+            out_pack[j] = exp_table.lookup(j, in_pack[j]);
         }
        
         res.write(out_pack);
@@ -96,42 +129,26 @@ ExpLogVarExpLoop:
 
 template <class data_T, class res_T, typename CONFIG_T>
 void explogvar(hls::stream<data_T> data[CONFIG_T::n_elem], hls::stream<res_T> res[CONFIG_T::n_elem]) {
-    // Initialize the lookup tables
-#ifdef __HLS_SYN__
-    bool initialized = false;
-    typename CONFIG_T::exp_table_t exp_table[CONFIG_T::table_size];
-#else
-    static bool initialized = false;
-    static typename CONFIG_T::exp_table_t exp_table[CONFIG_T::table_size];
-
-#endif
-    if (!initialized) {
-        // Note we are exponentiating the inputs, which have type data_T
-        init_explogvar_table<data_T, CONFIG_T>(exp_table);
-        initialized = true;
-    }
+    // Initialize the lookup table, if any, shared by table_ports of the lanes read in a cycle
+    // Note we are exponentiating the inputs, which have type data_T
+    explogvar_exp_bank<data_T, CONFIG_T, CONFIG_T::n_elem, CONFIG_T::reuse_factor> exp_table;
+    exp_table.init();
 
-        data_T in_pack[CONFIG_T::n_elem];
-        #pragma HLS ARRAY_RESHAPE variable=in_pack complete
-        ExpLogVarExpLoop:
-        for (unsigned j = 0; j < CONFIG_T::n_elem; j++) {
-            #pragma HLS UNROLL
-            in_pack[j] = data[j].read();
-            
-		}
-		res_T out_pack[CONFIG_T::n_elem];
-        #pragma HLS ARRAY_RESHAPE variable=out_pack complete
-		
-		ExpLogVarExpPackLoop:
-        for (unsigned j = 0; j < CONFIG_T::n_elem; j++) {
+    static const unsigned lanes_per_cycle = DIV_ROUNDUP(CONFIG_T::n_elem, CONFIG_T::reuse_factor);
+
+ExpLogVarReuseLoop:
+    for (unsigned r = 0; r < CONFIG_T::reuse_factor; r++) {
+        #pragma HLS PIPELINE II=1
+
+    ExpLogVarExpLoop:
+        for (unsigned k = 0; k < lanes_per_cycle; k++) {
             #pragma HLS UNROLL
-            unsigned x = explogvar_idx_from_real_val<data_T, CONFIG_T>(in_pack[j]);
-            out_pack[j] = exp_table[x];
+            unsigned j = r * lanes_per_cycle + k;
+            if (j >= CONFIG_T::n_elem)
+                continue;
+            res[j].write(exp_table.lookup(k, data[j].read()));
         }
-        for (unsigned j = 0; j < CONFIG_T::n_elem; j++) {
-            #pragma HLS UNROLL
-            res[j].write(out_pack[j]);
-		}
+    }
 }
 
 } // namespace nnet
@@ -4,11 +4,17 @@
 #include "hls_stream.h"
 #include "hls_math.h"
 #include "nnet_common.h"
+#include "nnet_context.h"
+#include "nnet_explogvar_stream.h"
+#include "nnet_lut.h"
 #include "ap_fixed.h"
 #include "nnet_stream.h"
 #include "nnet_types.h"
 #include <cmath>
 #include <bitset>
+#ifndef __SYNTHESIS__
+#include <stdint.h>
+#endif
 
 namespace nnet {
 
@@ -49,6 +55,8 @@ class RNG {
 };
 
 /* Generates an array of uniformly-distributed random numbers in 1 clock cycle. */
+// In C simulation the state is kept in native integers, which give the same sequence as the ap_uint<32>
+// arithmetic (all operations are modulo 2^32) at a fraction of the cost, and the lane loops vectorize
 template <unsigned N> class RNGArray {
   public:
     RNGArray() {
@@ -61,6 +69,7 @@ template <unsigned N> class RNGArray {
     }
 
     void next(ap_int<32> rnd[N]) {
+#ifdef __SYNTHESIS__
         //#pragma HLS INLINE
         RandomGenLoop: for (int i = 0; i < N; i++) {
             #pragma HLS UNROLL
@@ -73,15 +82,44 @@ template <unsigned N> class RNGArray {
             state[i] = x;
             rnd[i] = x;
         }
+#else
+        uint32_t x[N];
+        next(x);
+        for (int i = 0; i < N; i++) {
+            rnd[i] = (int32_t)x[i];
+        }
+#endif
     }
-    
+
+#ifndef __SYNTHESIS__
+    void next(uint32_t rnd[N]) {
+        for (int i = 0; i < N; i++) {
+            uint32_t x = state[i];
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+
+            state[i] = x;
+            rnd[i] = x;
+        }
+    }
+#endif
+
     ap_uint<32> set_seed(ap_uint<32> initial_state) {
+#ifdef __SYNTHESIS__
         ap_uint<32> current_state = initial_state;
+#else
+        uint32_t current_state = initial_state;
+#endif
         SeedGenLoop: for (int i = 0; i < N; i++) {
             // We use SplitMix32, a different family of RNG to generate the seeds,
             // to avoid common pitfalls with seed selection
             // Implementation from Kaito Udagawa, licensed under CC0
+#ifdef __SYNTHESIS__
             ap_uint<32> z = (current_state += 0x9e3779b9);
+#else
+            uint32_t z = (current_state += 0x9e3779b9u);
+#endif
             z = (z ^ (z >> 16)) * 0x85ebca6b;
             z = (z ^ (z >> 13)) * 0xc2b2ae35;
             state[i] = z ^ (z >> 16);
@@ -91,9 +129,34 @@ template <unsigned N> class RNGArray {
     }
 
   private:
+#ifdef __SYNTHESIS__
     ap_uint<32> state[N];
+#else
+    uint32_t state[N];
+#endif
 };
 
+#ifndef __SYNTHESIS__
+// sum * scale for the CLT generators, quantized to data_T as the ap_fixed product is
+template <class data_T, unsigned N> struct grng_scale_native {
+    static data_T apply(int64_t sum, const ap_fixed<64, 0> &scale) { return ap_int<32 + N>(sum) * scale; }
+};
+
+#ifdef __SIZEOF_INT128__
+// Truncation and wrap-around, the ap_fixed defaults, are a shift and a mask of the exact product
+template <int W, int I, unsigned N> struct grng_scale_native<ap_fixed<W, I, AP_TRN, AP_WRAP, 0>, N> {
+    static ap_fixed<W, I> apply(int64_t sum, const ap_fixed<64, 0> &scale) {
+        if (W > 64 || W - I > 64 || I - W > 63)
+            return ap_int<32 + N>(sum) * scale;
+        __int128 p = (__int128)sum * (int64_t)scale.range(63, 0).to_uint64();
+        ap_fixed<W, I> r;
+        r.range(W - 1, 0) = (uint64_t)(p >> (64 - (W - I > 64 ? 64 : W - I)));
+        return r;
+    }
+};
+#endif
+#endif
+
 template <unsigned N, class data_T> class GRNG {
   public:
     GRNG() {
@@ -105,6 +168,7 @@ template <unsigned N, class data_T> class GRNG {
     }
 
     data_T next() {
+#ifdef __SYNTHESIS__
         ap_int<32> rnd[N];
          #pragma HLS ARRAY_PARTITION variable=rnd complete
         rng_array.next(rnd);
@@ -119,6 +183,16 @@ template <unsigned N, class data_T> class GRNG {
         // #pragma HLS BIND_OP op=mul impl=fabric // Vitis, comment out for DSP
         // On Vivado, this is done with RESOURCE pragma, but doesn't work here.
         return rnd_normal * scale;
+#else
+        uint32_t rnd[N];
+        rng_array.next(rnd);
+
+        int64_t rnd_normal = 0;
+        for (int i = 0; i < N; i++) {
+            rnd_normal += (int32_t)rnd[i];
+        }
+        return grng_scale_native<data_T, N>::apply(rnd_normal, scale);
+#endif
     }
     
     ap_uint<32> set_seed(ap_uint<32> initial_state) {
@@ -152,93 +226,307 @@ template <unsigned SIZE, unsigned N, class data_T> class GRNGArray {
     GRNG<N, data_T> grng[SIZE];
 };
 
-// For generating single samples
-//GRNG<N_SAMPLES, result_t> normal(SEED);
-
-// For generating array of samples
-
-
-
-struct srn_config {
-    static const unsigned n_elem = 32;
-	  static const unsigned seed = 42;
-    static const unsigned n_samples = 4;
-    typedef ap_fixed<8, 3> seed_t;
-   
-};
-
 // *************************************************
-//       Exp logvar => exp(0.5 * inputs) 
+//       Alternative normal generators
 // *************************************************
+// All engines share the GRNGArray interface: construction from a 32-bit seed and next(data_T rnd[SIZE]),
+// which produces SIZE approximately N(0, 1) variates per call (one clock cycle when pipelined).
+// Costs are per lane, for a 32-bit xorshift state (32 FF, ~40 LUT) and the default types.
+//
+//  - GRNGArray (clt): sum of N 32-bit uniforms times 1/sqrt(N * 2^64 / 12). N * 32 FF, an N-input 32-bit adder
+//    tree and a 64-bit constant multiply (2-4 DSP, or ~1k LUT in fabric). Range +-sqrt(3 * N), tails lighter
+//    than normal (kurtosis 3 - 1.2 / N), no periodicity issues.
+//  - GRNGArrayShift (clt_shift): Irwin-Hall sum of 12 8-bit uniforms sliced from 3 xorshift words, whose
+//    standard deviation is 256 to within 0.001%, so the scaling is a shift. 96 FF, ~130 LUT, no DSP.
+//    Range +-5.98, kurtosis 2.9.
+//  - GRNGArrayInvCDF (inverse_cdf): one uniform word, the sign bit and a table of half-normal quantiles
+//    addressed by the next log2(TABLE_SIZE) bits. 32 FF, ~50 LUT, no DSP, plus the table (one 18k BRAM for
+//    1024 entries, replicated per two lanes, or LUTRAM). Exact quantiles at TABLE_SIZE levels per sign,
+//    tails truncated at 3.5 sigma for 1024 entries (variance 0.998).
+//  - GRNGArrayWallace (wallace): a pool of POOL normal values transformed four at a time by the orthogonal
+//    matrix (1/2)(J - 2I), which preserves the sum of squares, so the pool stays normal. 32 FF for the address
+//    state, four LUTRAM banks of POOL / 4 x 16 bits (one read and one write each per cycle, ~64 LUT for the
+//    default 64 entries), ~100 LUT, no DSP. Unit variance by construction and full tails up to the pool type
+//    range, but outputs are weakly correlated through the pool; pools below 64 entries visibly inflate the
+//    variance and flatten the tails. Best suited where cost matters more than independence.
+//  - GRNGArrayPhilox (philox): the CLT sum of N uniforms like GRNGArray, but the uniforms come from the
+//    counter-based Philox4x32-10 keyed by (seed, trial, timestep, lane) instead of a sequential state, so any
+//    trial or timestep can be generated independently and out of order. DIV_ROUNDUP(N, 4) Philox blocks of
+//    20 32x32 multiplies (~60 DSP unrolled) on top of the CLT cost; use it where reproducible replay or
+//    concurrent trials matter more than area.
+
+enum class grng_engine { clt = 0, clt_shift = 1, inverse_cdf = 2, wallace = 3, philox = 4 };
+
+// Engine output converted to data_T with saturation, so tails beyond its range clip instead of wrapping around to
+// the other sign (the default ap_fixed<8, 3> holds +-4, the clt_shift and wallace engines reach +-6 and +-8)
+template <class data_T, class x_T> inline data_T grng_saturate(const x_T &x) {
+    return ap_fixed<data_T::width, data_T::iwidth, data_T::qmode, AP_SAT>(x);
+}
 
+template <unsigned SIZE, class data_T> class GRNGArrayShift {
+  public:
+    GRNGArrayShift(ap_uint<32> seed) {
+        #pragma HLS ARRAY_PARTITION variable=rng complete
+        ap_uint<32> current_state = seed;
+        SeedLoop: for (int i = 0; i < SIZE; i++) {
+            current_state = rng[i].set_seed(current_state);
+        }
+    }
 
-inline float explogvar_fcn_float(float input) { return std::exp(0.5 * input); }
+    void next(data_T rnd[SIZE]) {
+        NextRandArrayLoop: for (int i = 0; i < SIZE; i++) {
+            #pragma HLS UNROLL
+            ap_int<32> u[3];
+            #pragma HLS ARRAY_PARTITION variable=u complete
+            rng[i].next(u);
+
+            ap_uint<12> sum = 0; // At most 12 * 255
+            SliceSumLoop: for (int k = 0; k < 12; k++) {
+                #pragma HLS UNROLL
+                sum += ap_uint<8>(u[k / 4].range(8 * (k % 4) + 7, 8 * (k % 4)));
+            }
+
+            // Subtract the mean, 12 * 127.5, and divide by 256 by placing the binary point
+            ap_fixed<13, 5> z;
+            z.range(12, 0) = ap_int<13>(sum) - 1530;
+            rnd[i] = grng_saturate<data_T>(z);
+        }
+    }
 
-template <class data_T, typename CONFIG_T> inline float explogvar_real_val_from_idx(unsigned i) {
-    // Treat the index as the top N bits
-    static constexpr int N = ceillog2(CONFIG_T::table_size); // number of address bits for table
-    data_T x(0);
-	//std::cout<<"i: "<<std::bitset<16>(i)<<std::endl; 
-    x(x.width - 1, x.width - N) = i;
-	//std::cout<<"x.width - 1: "<< x.width - 1 <<std::endl;
-	//std::cout<<"x.width - N: "<< x.width - N <<std::endl;
-	//std::cout<<"x(x.width - 1, x.width - N): "<< x.to_string(2) <<std::endl; // 2 for binary
-    return (float)x;
-}
+  private:
+    RNGArray<3> rng[SIZE];
+};
 
-template <class data_T, typename CONFIG_T> inline unsigned explogvar_idx_from_real_val(data_T x) {
-    // Slice the top N bits to get an index into the table
-    static constexpr int N = ceillog2(CONFIG_T::table_size); // number of address bits for table
-    ap_uint<N> y = x(x.width - 1, x.width - N);              // slice the top N bits of input
-    return (unsigned)y(N - 1, 0);
+inline float normal_quantile_float(float p) {
+    // Bisection on the normal CDF, only used to fill tables
+    double lo = -16., hi = 16.;
+    for (int i = 0; i < 64; i++) {
+        double mid = 0.5 * (lo + hi);
+        if (0.5 * std::erfc(-mid / std::sqrt(2.)) < p)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return 0.5 * (lo + hi);
 }
 
-template <class data_T, typename CONFIG_T>
-void init_explogvar_table(typename CONFIG_T::exp_table_t table_out[CONFIG_T::table_size]) {
-    // The template data_T is the data type used to address the table
+template <typename CONFIG_T> void init_normal_quantile_table(typename CONFIG_T::table_t table_out[CONFIG_T::table_size]) {
     for (unsigned i = 0; i < CONFIG_T::table_size; i++) {
-        // Slicing bits for address is going to round towards 0, so take the central value
-        float x = explogvar_real_val_from_idx<data_T, CONFIG_T>(i);
-        typename CONFIG_T::exp_table_t exp_x = explogvar_fcn_float(x);
-        table_out[i] = exp_x;
+        // Centre of the i-th slice of the upper half of the distribution
+        float p = 0.5 + (i + 0.5) / (2. * CONFIG_T::table_size);
+        table_out[i] = normal_quantile_float(p);
     }
 }
 
-struct explogvar_config {
-    static const unsigned n_elem = 32;
-    static const unsigned table_size = 1024;
-    typedef ap_fixed<18, 8> exp_table_t;
+struct normal_quantile_lut {
+    template <class table_T, unsigned N_TABLE, class input_T> static void fill(table_T *table) {
+        init_normal_quantile_table<lut_config<table_T, N_TABLE>>(table);
+    }
 };
 
+template <unsigned SIZE, class data_T, unsigned TABLE_SIZE = 1024> class GRNGArrayInvCDF {
+  public:
+    GRNGArrayInvCDF(ap_uint<32> seed) : rng(seed) {}
 
+    void next(data_T rnd[SIZE]) {
+#ifdef __HLS_SYN__
+        bool initialized = false;
+        data_T quantile_table[TABLE_SIZE];
+        if (!initialized) {
+            init_normal_quantile_table<lut_config<data_T, TABLE_SIZE>>(quantile_table);
+            initialized = true;
+        }
+#else
+        const data_T *quantile_table = lut_registry<normal_quantile_lut, data_T, TABLE_SIZE>::table();
+#endif
+        static constexpr int N = ceillog2(TABLE_SIZE);
 
-template <class data_T, class res_T, typename CONFIG_T>
-void explogvar(hls::stream<data_T> data[CONFIG_T::n_elem], hls::stream<res_T> res[CONFIG_T::n_elem]) {
- 
+        ap_int<32> u[SIZE];
+        #pragma HLS ARRAY_PARTITION variable=u complete
+        rng.next(u);
 
-        data_T in_pack[CONFIG_T::n_elem];
-        
-        ExpLogVarExpLoop:
-        for (unsigned j = 0; j < CONFIG_T::n_elem; j++) {
-            #pragma HLS UNROLL
-            
-            in_pack[j] = data[j].read();
-            
-		}
-		res_T out_pack[CONFIG_T::n_elem];
-        PRAGMA_DATA_PACK(out_pack)
-		
-		ExpLogVarExpPackLoop:
-        for (unsigned j = 0; j < CONFIG_T::n_elem; j++) {
+        NextRandArrayLoop: for (int i = 0; i < SIZE; i++) {
             #pragma HLS UNROLL
-            
+            ap_uint<N> idx = u[i].range(30, 31 - N);
+            data_T q = quantile_table[idx];
+            rnd[i] = u[i][31] ? data_T(-q) : q;
+        }
+    }
+
+  private:
+    RNGArray<SIZE> rng;
+};
+
+// POOL must be a multiple of 8, at most 4 << 7
+template <unsigned SIZE, class data_T, unsigned POOL = 64> class GRNGArrayWallace {
+  public:
+    typedef ap_fixed<16, 4, AP_RND_CONV, AP_SAT> pool_t;
+
+    GRNGArrayWallace(ap_uint<32> seed) : rng(seed) {
+        #pragma HLS ARRAY_PARTITION variable=pool complete dim=1
+        #pragma HLS ARRAY_PARTITION variable=pool block factor=4 dim=2
+        // The transforms keep the sum of squares of a pool, so it has to start at exactly POOL: the 16-quantiles
+        // of the normal distribution, scaled to unit mean square, with random signs
+        static const float pool_init[8] = {0.081588, 0.246807, 0.418538, 0.602583,
+                                           0.807861, 1.050887, 1.371381, 1.938159};
+        ap_int<32> u[SIZE];
+        PoolInitLoop: for (int k = 0; k < POOL; k++) {
+            rng.next(u);
+            for (int i = 0; i < SIZE; i++) {
+                pool_t x = pool_init[k % 8];
+                pool[i][k] = u[i][31] ? pool_t(-x) : x;
+            }
+        }
+        data_T rnd[SIZE];
+        PoolWarmupLoop: for (int k = 0; k < POOL; k++) {
+            next(rnd);
         }
-        for (unsigned j = 0; j < CONFIG_T::n_elem; j++) {
+    }
+
+    void next(data_T rnd[SIZE]) {
+        static const unsigned Q = POOL / 4;
+        static constexpr int N = ceillog2(Q) > 0 ? ceillog2(Q) : 1;
+
+        ap_int<32> u[SIZE];
+        #pragma HLS ARRAY_PARTITION variable=u complete
+        rng.next(u);
+
+        NextRandArrayLoop: for (int i = 0; i < SIZE; i++) {
             #pragma HLS UNROLL
-            res[j].write(out_pack[j]);
-		}
+            // One value from a random slot of each quarter of the pool, so the transforms mix the whole pool
+            unsigned addr[4];
+            pool_t x[4];
+            #pragma HLS ARRAY_PARTITION variable=x complete
+            for (int k = 0; k < 4; k++) {
+                addr[k] = k * Q + (Q > 1 ? unsigned(ap_uint<N>(u[i].range(N * (k + 1) - 1, N * k))) : 0);
+                x[k] = pool[i][addr[k]];
+            }
+
+            // Exact, the only rounding is the unbiased one back to the pool type
+            ap_fixed<19, 6> t = (ap_fixed<19, 6>(x[0]) + x[1] + x[2] + x[3]) >> 1;
+            pool_t y[4];
+            #pragma HLS ARRAY_PARTITION variable=y complete
+            for (int k = 0; k < 4; k++) {
+                y[k] = t - x[k];
+            }
+
+            // Rotate on write back and flip the sign of the output at random, both preserve the distribution
+            for (int k = 0; k < 4; k++) {
+                pool[i][addr[k]] = y[(k + 1) % 4];
+            }
+            rnd[i] = grng_saturate<data_T>(u[i][31] ? pool_t(-y[0]) : y[0]);
+        }
+    }
+
+  private:
+    RNGArray<SIZE> rng;
+    pool_t pool[SIZE][POOL];
+};
+
+// Philox4x32-10 bijection from Salmon et al., "Parallel random numbers: as easy as 1, 2, 3" (SC11),
+// matches the philox4x32 known-answer vectors of Random123
+inline void philox4x32(ap_uint<32> ctr[4], ap_uint<32> key0, ap_uint<32> key1) {
+    PhiloxRoundLoop: for (int r = 0; r < 10; r++) {
+        #pragma HLS UNROLL
+        ap_uint<64> p0 = ap_uint<64>(0xD2511F53u) * ctr[0];
+        ap_uint<64> p1 = ap_uint<64>(0xCD9E8D57u) * ctr[2];
+        ap_uint<32> c0 = p1.range(63, 32) ^ ctr[1] ^ key0;
+        ap_uint<32> c2 = p0.range(63, 32) ^ ctr[3] ^ key1;
+        ctr[0] = c0;
+        ctr[1] = p1.range(31, 0);
+        ctr[2] = c2;
+        ctr[3] = p0.range(31, 0);
+        key0 += 0x9E3779B9u;
+        key1 += 0xBB67AE85u;
+    }
 }
 
+template <unsigned SIZE, unsigned N, class data_T> class GRNGArrayPhilox {
+  public:
+    GRNGArrayPhilox(ap_uint<32> seed, ap_uint<32> trial = 0) : key(seed), trial(trial), timestep(0) {
+        scale = 1. / std::sqrt(N * 1537723804776605696.);
+    }
+
+    // Variates of any (trial, timestep), without touching the generator position
+    void generate(ap_uint<32> trial_id, ap_uint<32> step, data_T rnd[SIZE]) const {
+        NextRandArrayLoop: for (int i = 0; i < SIZE; i++) {
+            #pragma HLS UNROLL
+            ap_int<32 + N> rnd_normal = 0;
+            PhiloxBlockLoop: for (int b = 0; b < DIV_ROUNDUP(N, 4); b++) {
+                #pragma HLS UNROLL
+                // Counter (lane, timestep, trial, block) under the seed
+                ap_uint<32> ctr[4] = {ap_uint<32>(i), step, trial_id, ap_uint<32>(b)};
+                #pragma HLS ARRAY_PARTITION variable=ctr complete
+                philox4x32(ctr, key, 0);
+                SampleSumLoop: for (int k = 0; k < 4; k++) {
+                    #pragma HLS UNROLL
+                    if (4 * b + k < N)
+                        rnd_normal += ap_int<32>(ctr[k]);
+                }
+            }
+            rnd[i] = rnd_normal * scale;
+        }
+    }
+
+    void next(data_T rnd[SIZE]) {
+        generate(trial, timestep, rnd);
+        timestep++;
+    }
+
+    void seek(ap_uint<32> trial_id, ap_uint<32> step) {
+        trial = trial_id;
+        timestep = step;
+    }
+
+  private:
+    ap_uint<32> key;
+    ap_uint<32> trial;
+    ap_uint<32> timestep;
+    ap_fixed<64, 0> scale;
+};
+
+// Selects the generator class for a sample layer, N only applies to the CLT engines
+template <grng_engine ENGINE, unsigned SIZE, unsigned N, class data_T> struct grng_select {
+    typedef GRNGArray<SIZE, N, data_T> type;
+};
+template <unsigned SIZE, unsigned N, class data_T> struct grng_select<grng_engine::clt_shift, SIZE, N, data_T> {
+    typedef GRNGArrayShift<SIZE, data_T> type;
+};
+template <unsigned SIZE, unsigned N, class data_T> struct grng_select<grng_engine::inverse_cdf, SIZE, N, data_T> {
+    typedef GRNGArrayInvCDF<SIZE, data_T> type;
+};
+template <unsigned SIZE, unsigned N, class data_T> struct grng_select<grng_engine::wallace, SIZE, N, data_T> {
+    typedef GRNGArrayWallace<SIZE, data_T> type;
+};
+template <unsigned SIZE, unsigned N, class data_T> struct grng_select<grng_engine::philox, SIZE, N, data_T> {
+    typedef GRNGArrayPhilox<SIZE, N, data_T> type;
+};
+
+// Generator for one trial of a batch: sequential engines derive a seed per trial, the counter-based one keeps
+// the seed and starts at the trial's counter
+template <class grng_T> struct grng_trial {
+    static grng_T make(unsigned seed, unsigned trial) { return grng_T(seed + 0x9e3779b9u * trial); }
+};
+template <unsigned SIZE, unsigned N, class data_T> struct grng_trial<GRNGArrayPhilox<SIZE, N, data_T>> {
+    static GRNGArrayPhilox<SIZE, N, data_T> make(unsigned seed, unsigned trial) {
+        return GRNGArrayPhilox<SIZE, N, data_T>(seed, trial);
+    }
+};
+
+// For generating single samples
+//GRNG<N_SAMPLES, result_t> normal(SEED);
+
+// For generating array of samples
+
+
+
+struct srn_config {
+    static const unsigned n_elem = 32;
+	  static const unsigned seed = 42;
+    static const unsigned n_samples = 4;
+    typedef ap_fixed<8, 3> seed_t;
+   
+};
 
 struct config17 : explogvar_config {
     static const unsigned n_elem = 64;
@@ -248,61 +536,159 @@ struct config17 : explogvar_config {
 
 
 
-// array stream
-template <class mean_T, class explogvar_T, class res_T>
-void sample(
-          hls::stream<mean_T> mean_stream[64], 
-          hls::stream<explogvar_T> explogvar_stream[64],
-          hls::stream<res_T> res_stream[64],  
-          GRNGArray<64, 4, ap_fixed<8,3> > &normal
-) {
-   // Initialize the lookup tables
-   
-  #ifdef __HLS_SYN__
-      bool initialized = false;
-      ap_fixed<18,8,AP_RND_CONV,AP_SAT> exp_table[1024];
-  #else
-      static bool initialized = false;
-      static ap_fixed<18,8,AP_RND_CONV,AP_SAT> exp_table[1024];
-  
-  #endif
-      if (!initialized) {
-          // Note we are exponentiating the inputs, which have type data_T
-          init_explogvar_table<explogvar_T, config17>(exp_table);
-          initialized = true;
-      }
+// *************************************************
+//       Gaussian sample => mean + N(0,1) * exp(0.5 * logvar)
+// *************************************************
 
-    
- std::cout<<"USE EXPLOGVAR GAUSSIAN SAMPLE"<< std::endl;
-    
-   mean_T mean[64];
-   #pragma HLS ARRAY_PARTITION variable=mean complete
-   
-   explogvar_T explogvar[64];
-   #pragma HLS ARRAY_PARTITION variable=explogvar complete
-   
-   ap_fixed<8,3> rnd[64];
-   #pragma HLS ARRAY_PARTITION variable=rnd complete
-   
+struct sample_config {
+    // IO size: lanes (streams) and values per lane
+    static const unsigned n_elem = 64;
+    static const unsigned n_steps = 1;
+    // Posterior draws per input, so each lane writes n_samples * n_steps values: the draws back to back, or with
+    // interleave_samples the n_samples draws of a step one after the other, the trial order of a GRU with
+    // n_batch = n_samples
+    static const unsigned n_samples = 1;
+    static const bool interleave_samples = false;
+
+    // Internal info
+    static const unsigned table_size = 1024;
+    static const explogvar_impl exp_impl = explogvar_impl::table;
+    static const unsigned mant_table_size = 32; // range_reduced only, see nnet_exp_range_reduced.h
+    static const unsigned table_ports = 2;      // Lanes per cycle sharing one copy of the exp table
+    static const unsigned n_uniforms = 4; // Uniform variates summed per normal variate, clt engine only
+    static const unsigned seed = 42;
+    static const grng_engine rng_engine = grng_engine::clt;
+
+    // Resource reuse info: each multiplier serves reuse_factor lanes
+    static const unsigned reuse_factor = 1;
+    static const unsigned multiplier_limit = DIV_ROUNDUP(n_elem, reuse_factor);
+
+    // Internal data type definitions
+    typedef ap_fixed<18, 8, AP_RND_CONV, AP_SAT> exp_table_t;
+    typedef ap_ufixed<18, 1> mant_table_t;
+    typedef ap_fixed<8, 3> rnd_t;
+};
 
-    for (unsigned j = 0; j < 64; j++) {
-        #pragma HLS UNROLL
-        mean[j] = mean_stream[j].read();
-        explogvar[j] = exp_table[explogvar_idx_from_real_val<explogvar_T, config17>(explogvar_stream[j].read())];
-		}  
-  
-  //#pragma HLS pipeline
-  normal.next(rnd);
-   
-		for (int j = 0; j < 64; j++) {
-			#pragma HLS UNROLL
-      res_T res_data =  mean[j] + rnd[j]*explogvar[j];
-      res_stream[j].write(res_data);
-		}
+template <typename CONFIG_T> struct sample_rng_state {
+    typedef typename grng_select<CONFIG_T::rng_engine, CONFIG_T::n_elem, CONFIG_T::n_uniforms,
+                                 typename CONFIG_T::rnd_t>::type grng_t;
+    grng_t normal;
+#ifdef __SYNTHESIS__
+    sample_rng_state() : normal(CONFIG_T::seed) {}
+#else
+    // Each sample of a batch run is a trial with its own noise, sample 0 the sequence seeded with CONFIG_T::seed
+    sample_rng_state()
+        : normal(grng_trial<grng_t>::make(CONFIG_T::seed, (unsigned)current_context().sample_index())) {}
+#endif
+};
+
+// array stream, with a caller-owned generator (any of the engines above producing CONFIG_T::rnd_t)
+template <class mean_T, class explogvar_T, class res_T, typename CONFIG_T, class grng_T>
+void sample(hls::stream<mean_T> mean_stream[CONFIG_T::n_elem], hls::stream<explogvar_T> explogvar_stream[CONFIG_T::n_elem],
+            hls::stream<res_T> res_stream[CONFIG_T::n_elem], grng_T &normal) {
+    // Initialize the lookup table, if any, shared by table_ports of the lanes read in a cycle, with the
+    // implementation chosen by CONFIG_T::exp_impl
+    // Note we are exponentiating the inputs, which have type explogvar_T
+    explogvar_exp_bank<explogvar_T, CONFIG_T, CONFIG_T::n_elem, CONFIG_T::reuse_factor> exp_table;
+    exp_table.init();
+
+    static const unsigned lanes_per_cycle = DIV_ROUNDUP(CONFIG_T::n_elem, CONFIG_T::reuse_factor);
+
+    typename CONFIG_T::rnd_t rnd[CONFIG_T::n_elem];
+    #pragma HLS ARRAY_PARTITION variable=rnd complete
+
+    if (CONFIG_T::n_samples > 1) {
+        // The inputs are read and the standard deviations looked up once, then reused by every draw
+        mean_T mean_buf[CONFIG_T::n_steps][CONFIG_T::n_elem];
+        explogvar_T std_dev_buf[CONFIG_T::n_steps][CONFIG_T::n_elem];
+        #pragma HLS ARRAY_PARTITION variable=mean_buf complete dim=2
+        #pragma HLS ARRAY_PARTITION variable=std_dev_buf complete dim=2
+
+    SampleBufferStepLoop:
+        for (unsigned s = 0; s < CONFIG_T::n_steps; s++) {
+        SampleBufferReuseLoop:
+            for (unsigned r = 0; r < CONFIG_T::reuse_factor; r++) {
+                #pragma HLS PIPELINE II=1
+                for (unsigned k = 0; k < lanes_per_cycle; k++) {
+                    #pragma HLS UNROLL
+                    unsigned j = r * lanes_per_cycle + k;
+                    if (j >= CONFIG_T::n_elem)
+                        continue;
+                    mean_buf[s][j] = mean_stream[j].read();
+                    std_dev_buf[s][j] = exp_table.lookup(k, explogvar_stream[j].read());
+                }
+            }
+        }
 
-        
+        static const unsigned n_outer = CONFIG_T::interleave_samples ? CONFIG_T::n_steps : CONFIG_T::n_samples;
+        static const unsigned n_inner = CONFIG_T::interleave_samples ? CONFIG_T::n_samples : CONFIG_T::n_steps;
+
+    SampleDrawLoop:
+        for (unsigned o = 0; o < n_outer; o++) {
+        SampleDrawStepLoop:
+            for (unsigned i = 0; i < n_inner; i++) {
+                unsigned s = CONFIG_T::interleave_samples ? o : i;
+                normal.next(rnd);
+
+            SampleDrawReuseLoop:
+                for (unsigned r = 0; r < CONFIG_T::reuse_factor; r++) {
+                    #pragma HLS PIPELINE II=1
+                    #pragma HLS ALLOCATION operation instances=mul limit=CONFIG_T::multiplier_limit
+                    for (unsigned k = 0; k < lanes_per_cycle; k++) {
+                        #pragma HLS UNROLL
+                        unsigned j = r * lanes_per_cycle + k;
+                        if (j >= CONFIG_T::n_elem)
+                            continue;
+                        res_stream[j].write(mean_buf[s][j] + rnd[j] * std_dev_buf[s][j]);
+                    }
+                }
+            }
+        }
+        return;
+    }
 
- 
+SampleStepLoop:
+    for (unsigned s = 0; s < CONFIG_T::n_steps; s++) {
+        normal.next(rnd);
+
+    SampleReuseLoop:
+        for (unsigned r = 0; r < CONFIG_T::reuse_factor; r++) {
+            #pragma HLS PIPELINE II=1
+            #pragma HLS ALLOCATION operation instances=mul limit=CONFIG_T::multiplier_limit
+
+        SampleLaneLoop:
+            for (unsigned k = 0; k < lanes_per_cycle; k++) {
+                #pragma HLS UNROLL
+                unsigned j = r * lanes_per_cycle + k;
+                if (j >= CONFIG_T::n_elem)
+                    continue;
+                mean_T mean = mean_stream[j].read();
+                // Rounded to the input type, as in the original 64-lane kernel
+                explogvar_T std_dev = exp_table.lookup(k, explogvar_stream[j].read());
+                res_stream[j].write(mean + rnd[j] * std_dev);
+            }
+        }
+    }
+}
+
+// array stream, with the generator owned by the layer and seeded with CONFIG_T::seed
+template <class mean_T, class explogvar_T, class res_T, typename CONFIG_T>
+void sample(hls::stream<mean_T> mean_stream[CONFIG_T::n_elem], hls::stream<explogvar_T> explogvar_stream[CONFIG_T::n_elem],
+            hls::stream<res_T> res_stream[CONFIG_T::n_elem]) {
+#ifdef __SYNTHESIS__
+    static sample_rng_state<CONFIG_T> rng;
+#else
+    // Generator state lives in the model context, see nnet_context.h
+    sample_rng_state<CONFIG_T> &rng = context_state<sample_rng_state<CONFIG_T>>();
+#endif
+    sample<mean_T, explogvar_T, res_T, CONFIG_T>(mean_stream, explogvar_stream, res_stream, rng.normal);
+}
+
+// array stream, original 64-lane interface
+template <class mean_T, class explogvar_T, class res_T>
+void sample(hls::stream<mean_T> mean_stream[64], hls::stream<explogvar_T> explogvar_stream[64],
+            hls::stream<res_T> res_stream[64], GRNGArray<64, 4, ap_fixed<8, 3>> &normal) {
+    sample<mean_T, explogvar_T, res_T, sample_config>(mean_stream, explogvar_stream, res_stream, normal);
 }
     
     
@@ -3,14 +3,28 @@
 
 #include "hls_stream.h"
 #include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <map>
 #include <math.h>
+#include <mutex>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <vector>
 
+#if !defined(__SYNTHESIS__) && (defined(__unix__) || defined(__APPLE__))
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NNET_WEIGHTS_MMAP
+#endif
+
 namespace nnet {
 
 #ifndef __SYNTHESIS__
@@ -47,6 +61,133 @@ template <class T, size_t SIZE> void load_weights_from_txt(T *w, const char *fna
     }
 }
 
+// Binary weight file written by VivadoWriter.print_array_to_cpp, all fields little-endian:
+// a weights_bin_header, the shape as n_dims uint64 values, then n_values values of the given dtype.
+struct weights_bin_header {
+    char magic[8];      // "HLS4MLWB"
+    uint32_t dtype;     // weights_bin_float32 or weights_bin_float64
+    uint32_t n_dims;
+    uint64_t n_values;
+    uint64_t checksum;  // Sum of the payload as 64-bit words, modulo 2^64
+};
+
+enum weights_bin_dtype { weights_bin_float32 = 0, weights_bin_float64 = 1 };
+
+inline uint64_t weights_bin_checksum(const char *payload, size_t n_bytes) {
+    uint64_t sum = 0;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= n_bytes; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, payload + i, sizeof(word));
+        sum += word;
+    }
+    if (i < n_bytes) {
+        uint64_t word = 0;
+        std::memcpy(&word, payload + i, n_bytes - i);
+        sum += word;
+    }
+    return sum;
+}
+
+template <class T, class src_T> void convert_weights_from_bin(T *w, const char *payload, size_t n_values) {
+    const src_T *src = reinterpret_cast<const src_T *>(payload);
+    std::copy(src, src + n_values, w);
+}
+
+// Loads fname from WEIGHTS_DIR, mapping the file instead of reading it where mmap is available.
+// Returns false if the file does not exist, and exits on a malformed or mismatching file.
+template <class T, size_t SIZE> bool load_weights_from_bin(T *w, const char *fname) {
+
+    std::string full_path = std::string(WEIGHTS_DIR) + "/" + std::string(fname);
+
+#ifdef NNET_WEIGHTS_MMAP
+    int fd = open(full_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    size_t file_size = fstat(fd, &st) == 0 ? (size_t)st.st_size : 0;
+    void *mapped = file_size > 0 ? mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "ERROR: Unable to map " << std::string(fname) << std::endl;
+        exit(1);
+    }
+    const char *data = static_cast<const char *>(mapped);
+#else
+    std::ifstream infile(full_path.c_str(), std::ios::binary);
+    if (infile.fail()) {
+        return false;
+    }
+    std::vector<char> contents((std::istreambuf_iterator<char>(infile)), std::istreambuf_iterator<char>());
+    size_t file_size = contents.size();
+    const char *data = contents.data();
+#endif
+
+    weights_bin_header header;
+    bool valid = file_size >= sizeof(header);
+    size_t payload_offset = 0, payload_size = 0;
+    if (valid) {
+        std::memcpy(&header, data, sizeof(header));
+        size_t value_size = header.dtype == weights_bin_float32 ? sizeof(float) : sizeof(double);
+        payload_offset = sizeof(header) + header.n_dims * sizeof(uint64_t);
+        payload_size = header.n_values * value_size;
+        valid = std::memcmp(header.magic, "HLS4MLWB", sizeof(header.magic)) == 0 &&
+                (header.dtype == weights_bin_float32 || header.dtype == weights_bin_float64) &&
+                file_size == payload_offset + payload_size;
+    }
+    if (!valid) {
+        std::cerr << "ERROR: " << std::string(fname) << " is not a valid weight file" << std::endl;
+        exit(1);
+    }
+    if (header.n_values != SIZE) {
+        std::cerr << "ERROR: Expected " << SIZE << " values";
+        std::cerr << " but " << std::string(fname) << " holds " << header.n_values << " values" << std::endl;
+        exit(1);
+    }
+    if (weights_bin_checksum(data + payload_offset, payload_size) != header.checksum) {
+        std::cerr << "ERROR: Checksum mismatch in " << std::string(fname) << std::endl;
+        exit(1);
+    }
+
+    if (header.dtype == weights_bin_float32) {
+        convert_weights_from_bin<T, float>(w, data + payload_offset, SIZE);
+    } else {
+        convert_weights_from_bin<T, double>(w, data + payload_offset, SIZE);
+    }
+
+#ifdef NNET_WEIGHTS_MMAP
+    munmap(mapped, file_size);
+#endif
+    return true;
+}
+
+// Whether <name>.txt was modified after <name>.bin was written, e.g. edited by hand, so the .bin is stale.
+// Modification times are only compared where stat() is available.
+inline bool weights_txt_is_newer(const char *name) {
+#ifdef NNET_WEIGHTS_MMAP
+    std::string path = std::string(WEIGHTS_DIR) + "/" + std::string(name);
+    struct stat bin_st, txt_st;
+    if (stat((path + ".bin").c_str(), &bin_st) != 0 || stat((path + ".txt").c_str(), &txt_st) != 0) {
+        return false;
+    }
+    return txt_st.st_mtime > bin_st.st_mtime;
+#else
+    return false;
+#endif
+}
+
+// Loads the weights from <name>.bin if present and not older than <name>.txt, otherwise from <name>.txt
+template <class T, size_t SIZE> void load_weights(T *w, const char *name) {
+    if (weights_txt_is_newer(name)) {
+        std::cerr << "WARNING: " << std::string(name) << ".txt is newer than " << std::string(name)
+                  << ".bin, loading the .txt file" << std::endl;
+    } else if (load_weights_from_bin<T, SIZE>(w, (std::string(name) + ".bin").c_str())) {
+        return;
+    }
+    load_weights_from_txt<T, SIZE>(w, (std::string(name) + ".txt").c_str());
+}
+
 template <class T, size_t SIZE> void load_compressed_weights_from_txt(T *w, const char *fname) {
 
     std::string full_path = std::string(WEIGHTS_DIR) + "/" + std::string(fname);
@@ -274,41 +415,229 @@ template <class data_T> void save_layer_output(hls::stream<data_T> &data, const
         out.close();
     }
 }
-/*
-template <class data_T> void save_layer_output(hls::stream<data_T> data[SIZE], const char *layer_name, size_t SIZE, size_t layer_size) {
-    if (!trace_enabled)
-        return;
+// Traces the output stream (or array of streams) of a layer without draining and refilling it: a tap on the
+// streams copies every element into the trace storage as the layer writes it. The elements of an array of
+// streams are stored lane by lane, in the layout of the layer output. The tap is removed when the object
+// goes out of scope, declare it after the streams and before the layer call.
+template <class data_T> class stream_trace {
+  public:
+    // Stream of packed elements (io_stream)
+    stream_trace(hls::stream<data_T> &data, const char *layer_name, size_t layer_size)
+        : streams_(&data), n_lanes_(1), lanes_(1) {
+        if (attach(layer_name, layer_size)) {
+            set_taps(saves_double() ? &tap_packed<double> : &tap_packed<float>);
+        }
+    }
 
-    if (trace_outputs) {
-        if (trace_outputs->count(layer_name) > 0) {
-            if (trace_type_size == 4) {
-                save_output_array<data_T, float>(data, (float *)(*trace_outputs)[layer_name], layer_size);
-            } else if (trace_type_size == 8) {
-                save_output_array<data_T, double>(data, (double *)(*trace_outputs)[layer_name], layer_size);
-            } else {
+    // Array of streams with one element per lane (io_array_stream)
+    stream_trace(hls::stream<data_T> data[], size_t n_lanes, const char *layer_name, size_t layer_size)
+        : streams_(data), n_lanes_(n_lanes), lanes_(n_lanes) {
+        if (attach(layer_name, layer_size)) {
+            set_taps(saves_double() ? &tap_lane<double> : &tap_lane<float>);
+        }
+    }
+
+    ~stream_trace() {
+        if (ptr_ == NULL) {
+            return;
+        }
+        for (size_t i = 0; i < n_lanes_; i++) {
+            streams_[i].set_tap(NULL, NULL);
+        }
+        if (!log_.empty()) {
+            std::ostringstream filename;
+            filename << "./tb_data/" << layer_name_ << "_output.log";
+            std::fstream out;
+            out.open(filename.str(), std::ios::app);
+            assert(out.is_open());
+            for (size_t i = 0; i < log_.size(); i++) {
+                out << log_[i] << " ";
+            }
+            out << std::endl;
+            out.close();
+        }
+    }
+
+  private:
+    stream_trace(const stream_trace &);
+    stream_trace &operator=(const stream_trace &);
+
+    struct lane {
+        stream_trace *trace;
+        size_t index;
+        size_t count;
+    };
+
+    bool attach(const char *layer_name, size_t layer_size) {
+        ptr_ = NULL;
+        layer_name_ = layer_name;
+        layer_size_ = layer_size;
+        if (!trace_enabled)
+            return false;
+
+        if (trace_outputs) {
+            if (trace_outputs->count(layer_name) == 0) {
+                std::cout << "Layer name: " << layer_name << " not found in debug storage!" << std::endl;
+                return false;
+            }
+            if (trace_type_size != 4 && trace_type_size != 8) {
                 std::cout << "Unknown trace type!" << std::endl;
+                return false;
             }
+            ptr_ = (*trace_outputs)[layer_name];
         } else {
-            std::cout << "Layer name: " << layer_name << " not found in debug storage!" << std::endl;
+            // Written to the log file when the layer is done
+            log_.resize(layer_size);
+            ptr_ = &log_[0];
         }
-    } else {
-        std::ostringstream filename;
-        filename << "./tb_data/" << layer_name << "_output.log"; // TODO if run as a shared lib, path should be ../tb_data
-        std::fstream out;
-        out.open(filename.str(), std::ios::app);
-        assert(out.is_open());
-        for (size_t i = 0; i < layer_size / data_T::size; i++) {
-            data_T ctype = data.read();
-            for (size_t j = 0; j < data_T::size; j++) {
-                out << float(ctype[j]) << " "; // We don't care about precision in text files
-            }
-            data.write(ctype);
+        return true;
+    }
+
+    // The log file is written in float
+    bool saves_double() const { return trace_outputs && trace_type_size == 8; }
+
+    typedef void (*tap_function)(void *, const data_T &);
+
+    void set_taps(tap_function tap) {
+        for (size_t i = 0; i < n_lanes_; i++) {
+            lanes_[i].trace = this;
+            lanes_[i].index = i;
+            lanes_[i].count = 0;
+            streams_[i].set_tap(tap, &lanes_[i]);
         }
-        out << std::endl;
-        out.close();
     }
+
+    template <class save_T> static void tap_packed(void *context, const data_T &elem) {
+        lane &l = *static_cast<lane *>(context);
+        save_T *ptr = static_cast<save_T *>(l.trace->ptr_);
+        for (size_t j = 0; j < data_T::size; j++) {
+            size_t pos = l.count * data_T::size + j;
+            if (pos < l.trace->layer_size_)
+                ptr[pos] = save_T(elem[j]);
+        }
+        l.count++;
+    }
+
+    template <class save_T> static void tap_lane(void *context, const data_T &elem) {
+        lane &l = *static_cast<lane *>(context);
+        size_t pos = l.count * l.trace->n_lanes_ + l.index;
+        if (pos < l.trace->layer_size_)
+            static_cast<save_T *>(l.trace->ptr_)[pos] = save_T(elem);
+        l.count++;
+    }
+
+    hls::stream<data_T> *streams_;
+    size_t n_lanes_;
+    std::vector<lane> lanes_;
+    void *ptr_;
+    std::string layer_name_;
+    size_t layer_size_;
+    std::vector<float> log_;
+};
+
+// FIFO occupancy profile: for each named stream of the top function (an array of streams counts as one,
+// taking its fullest stream), the largest number of elements it held in any call
+inline std::map<std::string, size_t> &fifo_high_water_marks() {
+    static std::map<std::string, size_t> high_water_marks;
+    return high_water_marks;
+}
+
+inline std::mutex &fifo_high_water_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+inline void record_fifo_depth(const char *name, size_t high_water_mark) {
+    std::lock_guard<std::mutex> lock(fifo_high_water_mutex());
+    size_t &max_depth = fifo_high_water_marks()[name];
+    max_depth = std::max(max_depth, high_water_mark);
+}
+
+template <class data_T> void record_fifo_depth(hls::stream<data_T> &data, const char *name) {
+    record_fifo_depth(name, data.high_water_mark());
+}
+
+template <class data_T> void record_fifo_depth(hls::stream<data_T> data[], const char *name, size_t n_streams) {
+    size_t high_water_mark = 0;
+    for (size_t i = 0; i < n_streams; i++) {
+        high_water_mark = std::max(high_water_mark, data[i].high_water_mark());
+    }
+    record_fifo_depth(name, high_water_mark);
+}
+
+// Writes the profile as a JSON object mapping the stream names to their high-water marks
+inline void write_fifo_depths(const char *filename) {
+    std::lock_guard<std::mutex> lock(fifo_high_water_mutex());
+    std::ofstream out(filename);
+    out << "{";
+    const char *sep = "\n";
+    for (std::map<std::string, size_t>::const_iterator i = fifo_high_water_marks().begin();
+         i != fifo_high_water_marks().end(); i++) {
+        out << sep << "    \"" << i->first << "\": " << i->second;
+        sep = ",\n";
+    }
+    out << "\n}\n";
+}
+
+// Per-layer profile of the top function, kept by a model written for ModelGraph.profile_performance(). The
+// trip count, multiply-accumulates and cycles of a call are static estimates from the layer configuration,
+// the invocations and the wall-clock time are measured.
+struct layer_profile {
+    layer_profile(const char *name, unsigned long trip_count, unsigned long macs, unsigned long cycles)
+        : name(name), trip_count(trip_count), macs(macs), cycles(cycles), invocations(0), wall_time_ns(0) {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        registry().push_back(this);
+    }
+
+    static std::vector<layer_profile *> &registry() {
+        static std::vector<layer_profile *> profiles;
+        return profiles;
+    }
+
+    static std::mutex &registry_mutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    std::string name;
+    unsigned long trip_count;
+    unsigned long macs;
+    unsigned long cycles;
+    std::atomic<unsigned long> invocations;
+    std::atomic<unsigned long long> wall_time_ns;
+};
+
+// Times one call of a layer
+class layer_timer {
+  public:
+    explicit layer_timer(layer_profile &profile) : profile_(profile), start_(std::chrono::steady_clock::now()) {}
+
+    void stop() {
+        std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start_;
+        profile_.invocations++;
+        profile_.wall_time_ns += elapsed.count();
+    }
+
+  private:
+    layer_profile &profile_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Writes the profile as a JSON object mapping the layer names, in execution order, to their counters
+inline void write_layer_profile(const char *filename) {
+    std::lock_guard<std::mutex> lock(layer_profile::registry_mutex());
+    std::ofstream out(filename);
+    out << "{";
+    const char *sep = "\n";
+    for (size_t i = 0; i < layer_profile::registry().size(); i++) {
+        const layer_profile &profile = *layer_profile::registry()[i];
+        out << sep << "    \"" << profile.name << "\": {\"invocations\": " << profile.invocations
+            << ", \"trip_count\": " << profile.trip_count << ", \"macs\": " << profile.macs
+            << ", \"cycles\": " << profile.cycles << ", \"wall_time\": " << profile.wall_time_ns * 1e-9 << "}";
+        sep = ",\n";
+    }
+    out << "\n}\n";
 }
-*/
 #endif
 
 template <class src_T, class dst_T, size_t OFFSET, size_t SIZE> void copy_data(std::vector<src_T> src, dst_T dst[SIZE]) {
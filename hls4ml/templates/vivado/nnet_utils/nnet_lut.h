@@ -0,0 +1,94 @@
+#ifndef NNET_LUT_H_
+#define NNET_LUT_H_
+
+namespace nnet {
+
+// Minimal config exposing the table type and size the init_*_table functions expect from CONFIG_T
+template <class table_T, unsigned N_TABLE> struct lut_config {
+    typedef table_T table_t;
+    typedef table_T exp_table_t;
+    static const unsigned table_size = N_TABLE;
+};
+
+// Table values computed at build time. The writer specializes this in parameters.h for the tables of the model,
+// with values() returning the N_TABLE entries before the conversion to table_T; other tables return 0 and are
+// filled at run time
+template <class fill_T, class table_T, unsigned N_TABLE, class input_T = void> struct lut_data {
+    static const double *values() { return 0; }
+};
+
+// C simulation registry of lookup tables. A table is identified by the functor filling it, its size,
+// its element type and the input type it is addressed with, so all layers whose configs agree on
+// those share one table, built once per process on first use, from lut_data if the writer emitted it.
+// fill_T provides
+//     template <class table_T, unsigned N_TABLE, class input_T> static void fill(table_T *table);
+template <class fill_T, class table_T, unsigned N_TABLE, class input_T = void> class lut_registry {
+  public:
+    static const table_T *table() {
+        // Static local initialization is thread-safe, concurrent callers wait for the first one
+        static const storage tables;
+        return tables.data;
+    }
+
+  private:
+    struct storage {
+        table_T data[N_TABLE];
+        storage() {
+            const double *values = lut_data<fill_T, table_T, N_TABLE, input_T>::values();
+            if (values == 0) {
+                fill_T::template fill<table_T, N_TABLE, input_T>(data);
+                return;
+            }
+            for (unsigned i = 0; i < N_TABLE; i++) {
+                data[i] = values[i];
+            }
+        }
+    };
+};
+
+// Lookup table read by N_LANES lanes of an array-stream kernel, one entry per lane. Instead of one copy per
+// lane, each physical copy (bank) serves PORTS lanes per cycle, 2 pairing lanes on the ports of a true dual-port
+// BRAM, and REUSE time-multiplexes the lanes so only DIV_ROUNDUP(N_LANES, REUSE) read in a cycle. That leaves
+// n_banks = DIV_ROUNDUP(lanes_per_cycle, PORTS) copies. Kernels visit the lanes as
+//     for r < REUSE (pipelined, II=1), for k < lanes_per_cycle (unrolled): lane r * lanes_per_cycle + k
+// and read with lookup(k, index). In C simulation every bank is the shared lut_registry table.
+template <class table_T, unsigned N_LANES, unsigned TABLE_SIZE, unsigned PORTS = 2, unsigned REUSE = 1> class lut_bank {
+  public:
+    static const unsigned lanes_per_cycle = (N_LANES + REUSE - 1) / REUSE;
+    static const unsigned n_banks = (lanes_per_cycle + PORTS - 1) / PORTS;
+
+    // Fills the banks with fill_T, see lut_registry
+    template <class fill_T, class input_T> void init() {
+#ifdef __HLS_SYN__
+        #pragma HLS ARRAY_PARTITION variable=banks complete dim=1
+        #pragma HLS RESOURCE variable=banks core=ROM_2P_BRAM
+    LutBankInitLoop:
+        for (unsigned b = 0; b < n_banks; b++) {
+            fill_T::template fill<table_T, TABLE_SIZE, input_T>(banks[b]);
+        }
+#else
+        table = lut_registry<fill_T, table_T, TABLE_SIZE, input_T>::table();
+#endif
+    }
+
+    // Entry index for the k-th lane read in a cycle
+    table_T lookup(unsigned k, unsigned index) const {
+        #pragma HLS INLINE
+#ifdef __HLS_SYN__
+        return banks[k / PORTS][index];
+#else
+        return table[index];
+#endif
+    }
+
+  private:
+#ifdef __HLS_SYN__
+    table_T banks[n_banks][TABLE_SIZE];
+#else
+    const table_T *table;
+#endif
+};
+
+} // namespace nnet
+
+#endif
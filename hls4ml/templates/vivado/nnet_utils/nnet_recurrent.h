@@ -4,11 +4,23 @@
 #include "hls_stream.h"
 #include "nnet_activation.h"
 #include "nnet_common.h"
+#include "nnet_context.h"
 #include "nnet_dense.h"
 #include "nnet_recr_activations.h"
+#include "nnet_types.h"
+#include <type_traits>
 
 namespace nnet {
 
+// serial:    one GRU step after the other, input and recurrent dense inside every step
+// pipelined: input projection of step t+1 overlaps the recurrent half of step t,
+//            the timestep loop is pipelined with II=recurrent_ii. h(t) depends on h(t-1) through
+//            the whole recurrent half (dense, activations and blend), so the II that can be met is
+//            its latency; hls4ml derives recurrent_ii from the recurrent reuse factor unless set
+// precomputed: input projection of all timesteps runs as its own DATAFLOW process
+//            (reuse of mult_config1) and streams into a recurrent-only core
+enum class recurrent_implementation { serial = 0, pipelined = 1, precomputed = 2 };
+
 struct lstm_config {
     // Internal data type definitions
     typedef float weight_t;
@@ -108,6 +120,12 @@ void lstm(bool reset_state, data_T data[CONFIG_T::n_in], res_T h_newstate[CONFIG
     }
 }
 
+// State kept between calls by lstm_static, owned by the model context in C simulation
+template <class res_T, typename CONFIG_T> struct lstm_static_state {
+    res_T h_state[CONFIG_T::n_state];
+    res_T s_state[CONFIG_T::n_state];
+};
+
 template <class data_T, class res_T, typename CONFIG_T>
 void lstm_static(bool reset_state, data_T data[CONFIG_T::n_in], res_T h_newstate[CONFIG_T::n_state],
                  res_T s_newstate[CONFIG_T::n_state],
@@ -115,8 +133,14 @@ void lstm_static(bool reset_state, data_T data[CONFIG_T::n_in], res_T h_newstate
                  typename CONFIG_T::weight_t param_r[CONFIG_T::n_state * 4 * CONFIG_T::n_state],
                  typename CONFIG_T::bias_t param_b[CONFIG_T::n_state * 4],
                  typename CONFIG_T::bias_t param_br[CONFIG_T::n_state * 4]) {
+#ifdef __SYNTHESIS__
     static res_T h_state[CONFIG_T::n_state];
     static res_T s_state[CONFIG_T::n_state];
+#else
+    lstm_static_state<res_T, CONFIG_T> &state = nnet::context_state<lstm_static_state<res_T, CONFIG_T>>();
+    res_T *h_state = state.h_state;
+    res_T *s_state = state.s_state;
+#endif
     // Initialize the state variable -- will maintain state between function calls
     typename CONFIG_T::accum_t tmpres[CONFIG_T::n_state * 4];
     typename CONFIG_T::accum_t tmpres_state[CONFIG_T::n_state * 4];
@@ -317,6 +341,9 @@ struct gru_config {
     static const bool store_weights_in_bram = false;
     static const bool use_static = true;
     static const unsigned n_zeros = 0;
+    static const recurrent_implementation implementation = recurrent_implementation::serial;
+    static const unsigned recurrent_ii = 1;
+    static const unsigned n_batch = 1;
 
     template <class x_T, class y_T, class config_T> using activation_recr = nnet::activation::relu<x_T, y_T, config_T>;
     template <class x_T, class y_T, class config_T> using activation = nnet::activation::relu<x_T, y_T, config_T>;
@@ -347,15 +374,12 @@ struct qgru_config {
     template <class x_T, class y_T, class config_T> using activation = nnet::activation::relu<x_T, y_T, config_T>;
 };
 
-template <class data_T, class res_T, typename CONFIG_T>
-void gru(bool reset_state, data_T data[CONFIG_T::n_in], res_T h_newstate[CONFIG_T::n_state],
-         typename CONFIG_T::weight_t param[CONFIG_T::n_state * 3 * CONFIG_T::n_in], // TODO - Check the layout of the param
-                                                                                    // weights - refer page in copy!!
-         typename CONFIG_T::weight_t param_zr[CONFIG_T::n_state * 3 * CONFIG_T::n_state],
-         typename CONFIG_T::bias_t param_b[CONFIG_T::n_state * 3],
-         typename CONFIG_T::bias_t param_br[CONFIG_T::n_state * 3]) {
-    // Initialize the state variable -- will maintain state between function calls
-    typename CONFIG_T::accum_t tmpres[CONFIG_T::n_state * 3];
+// Recurrent half of the GRU step: everything that depends on h(t-1).
+// tmpres holds the input projection Wx*x(t)+b of the current timestep.
+template <class proj_T, class res_T, typename CONFIG_T>
+void gru_recurrent(proj_T tmpres[CONFIG_T::n_state * 3], res_T h_newstate[CONFIG_T::n_state],
+                   typename CONFIG_T::weight_t param_zr[CONFIG_T::n_state * 3 * CONFIG_T::n_state],
+                   typename CONFIG_T::bias_t param_br[CONFIG_T::n_state * 3]) {
     typename CONFIG_T::accum_t tmpres_state_zr[CONFIG_T::n_state * 3];
     typename CONFIG_T::accum_t tmpres_state_h[CONFIG_T::n_state];
     res_T tmpres_zr[CONFIG_T::n_state * 2];   // activated i,f,o matrices (keras notation)
@@ -372,7 +396,6 @@ void gru(bool reset_state, data_T data[CONFIG_T::n_in], res_T h_newstate[CONFIG_
     #pragma HLS ARRAY_PARTITION variable=inputacc_zr     complete
     #pragma HLS ARRAY_PARTITION variable=inputacc_h      complete
 
-    nnet::dense<data_T, typename CONFIG_T::accum_t, typename CONFIG_T::mult_config1>(data, tmpres, param, param_b);
     nnet::dense<res_T, typename CONFIG_T::accum_t, typename CONFIG_T::mult_config2>(h_newstate, tmpres_state_zr, param_zr,
                                                                                     param_br);
 
@@ -415,15 +438,25 @@ void gru(bool reset_state, data_T data[CONFIG_T::n_in], res_T h_newstate[CONFIG_
 }
 
 template <class data_T, class res_T, typename CONFIG_T>
-void gru_static(bool reset_state, data_T data[CONFIG_T::n_in], res_T h_newstate[CONFIG_T::n_state],
-                typename CONFIG_T::weight_t param[CONFIG_T::n_state * 3 * CONFIG_T::n_in],
-                typename CONFIG_T::weight_t param_zr[CONFIG_T::n_state * 3 * CONFIG_T::n_state],
-                typename CONFIG_T::bias_t param_b[CONFIG_T::n_state * 3],
-                typename CONFIG_T::bias_t param_br[CONFIG_T::n_state * 3]) {
-    // Initialize the state variable -- will maintain state between function calls
+void gru(bool reset_state, data_T data[CONFIG_T::n_in], res_T h_newstate[CONFIG_T::n_state],
+         typename CONFIG_T::weight_t param[CONFIG_T::n_state * 3 * CONFIG_T::n_in], // TODO - Check the layout of the param
+                                                                                    // weights - refer page in copy!!
+         typename CONFIG_T::weight_t param_zr[CONFIG_T::n_state * 3 * CONFIG_T::n_state],
+         typename CONFIG_T::bias_t param_b[CONFIG_T::n_state * 3],
+         typename CONFIG_T::bias_t param_br[CONFIG_T::n_state * 3]) {
+    typename CONFIG_T::accum_t tmpres[CONFIG_T::n_state * 3];
+    #pragma HLS ARRAY_PARTITION variable=tmpres complete
 
-    static res_T h_state[CONFIG_T::n_state];
-    typename CONFIG_T::accum_dense_t tmpres[CONFIG_T::n_state * 3];
+    nnet::dense<data_T, typename CONFIG_T::accum_t, typename CONFIG_T::mult_config1>(data, tmpres, param, param_b);
+    nnet::gru_recurrent<typename CONFIG_T::accum_t, res_T, CONFIG_T>(tmpres, h_newstate, param_zr, param_br);
+}
+
+// One recurrent step with the quantized-state datapath of gru_static, updating h_state in place.
+// Stateless, so callers can keep as many hidden states as they like.
+template <class proj_T, class res_T, typename CONFIG_T>
+void gru_static_step(proj_T tmpres[CONFIG_T::n_state * 3], res_T h_state[CONFIG_T::n_state],
+                     typename CONFIG_T::weight_t param_zr[CONFIG_T::n_state * 3 * CONFIG_T::n_state],
+                     typename CONFIG_T::bias_t param_br[CONFIG_T::n_state * 3]) {
     typename CONFIG_T::accum_dense_t tmpres_state_zr[CONFIG_T::n_state * 3];
     typename CONFIG_T::accum_t tmpres_state_h[CONFIG_T::n_state];
     typename CONFIG_T::recr_act_t tmpres_zr[CONFIG_T::n_state * 2];   // activated i,f,o matrices (keras notation)
@@ -434,7 +467,6 @@ void gru_static(bool reset_state, data_T data[CONFIG_T::n_in], res_T h_newstate[
     typename CONFIG_T::state_t qh_state[CONFIG_T::n_state];
 
     #pragma HLS ARRAY_PARTITION variable=h_state         complete
-    #pragma HLS ARRAY_PARTITION variable=h_newstate      complete
     #pragma HLS ARRAY_PARTITION variable=tmpres          complete
     #pragma HLS ARRAY_PARTITION variable=tmpres_state_zr complete
     #pragma HLS ARRAY_PARTITION variable=tmpres_state_h  complete
@@ -443,19 +475,11 @@ void gru_static(bool reset_state, data_T data[CONFIG_T::n_in], res_T h_newstate[
     #pragma HLS ARRAY_PARTITION variable=inputacc_zr     complete
     #pragma HLS ARRAY_PARTITION variable=inputacc_h      complete
 
-    if (reset_state) {
-        for (int i_h_state = 0; i_h_state < (CONFIG_T::n_state); i_h_state++) {
-            #pragma HLS UNROLL
-            h_state[i_h_state] = h_newstate[i_h_state];
-        }
-    }
-
     for (int i_h_state = 0; i_h_state < (CONFIG_T::n_state); i_h_state++) {
         #pragma HLS UNROLL
         qh_state[i_h_state] = (typename CONFIG_T::state_t) h_state[i_h_state];
     }
     
-    nnet::dense<data_T, typename CONFIG_T::accum_dense_t, typename CONFIG_T::mult_config1>(data, tmpres, param, param_b);
     nnet::dense<typename CONFIG_T::state_t, typename CONFIG_T::accum_dense_t, typename CONFIG_T::mult_config2>(qh_state, tmpres_state_zr, param_zr,
                                                                                     param_br);
 
@@ -494,10 +518,56 @@ void gru_static(bool reset_state, data_T data[CONFIG_T::n_in], res_T h_newstate[
     for (int iacc = 0; iacc < (CONFIG_T::n_state); iacc++) {
         #pragma HLS UNROLL
         h_state[iacc] = (res_T)(tmpres_h[iacc] * (1 - tmpres_zr[iacc]) + qh_state[iacc] * tmpres_zr[iacc]);
-        h_newstate[iacc] = h_state[iacc];
     }
 }
 
+// State kept between calls by gru_static, owned by the model context in C simulation
+template <class res_T, typename CONFIG_T> struct gru_static_state { res_T h_state[CONFIG_T::n_state]; };
+
+// Recurrent half of gru_static. The hidden state is kept in h_state between calls
+// and is reloaded from h_newstate when reset_state is set.
+template <class proj_T, class res_T, typename CONFIG_T>
+void gru_static_recurrent(bool reset_state, proj_T tmpres[CONFIG_T::n_state * 3],
+                          res_T h_newstate[CONFIG_T::n_state],
+                          typename CONFIG_T::weight_t param_zr[CONFIG_T::n_state * 3 * CONFIG_T::n_state],
+                          typename CONFIG_T::bias_t param_br[CONFIG_T::n_state * 3]) {
+    // Initialize the state variable -- will maintain state between function calls
+#ifdef __SYNTHESIS__
+    static res_T h_state[CONFIG_T::n_state];
+#else
+    res_T *h_state = nnet::context_state<gru_static_state<res_T, CONFIG_T>>().h_state;
+#endif
+    #pragma HLS ARRAY_PARTITION variable=h_state    complete
+    #pragma HLS ARRAY_PARTITION variable=h_newstate complete
+
+    if (reset_state) {
+        for (int i_h_state = 0; i_h_state < (CONFIG_T::n_state); i_h_state++) {
+            #pragma HLS UNROLL
+            h_state[i_h_state] = h_newstate[i_h_state];
+        }
+    }
+
+    nnet::gru_static_step<proj_T, res_T, CONFIG_T>(tmpres, h_state, param_zr, param_br);
+
+    for (int i_h_state = 0; i_h_state < (CONFIG_T::n_state); i_h_state++) {
+        #pragma HLS UNROLL
+        h_newstate[i_h_state] = h_state[i_h_state];
+    }
+}
+
+template <class data_T, class res_T, typename CONFIG_T>
+void gru_static(bool reset_state, data_T data[CONFIG_T::n_in], res_T h_newstate[CONFIG_T::n_state],
+                typename CONFIG_T::weight_t param[CONFIG_T::n_state * 3 * CONFIG_T::n_in],
+                typename CONFIG_T::weight_t param_zr[CONFIG_T::n_state * 3 * CONFIG_T::n_state],
+                typename CONFIG_T::bias_t param_b[CONFIG_T::n_state * 3],
+                typename CONFIG_T::bias_t param_br[CONFIG_T::n_state * 3]) {
+    typename CONFIG_T::accum_dense_t tmpres[CONFIG_T::n_state * 3];
+    #pragma HLS ARRAY_PARTITION variable=tmpres complete
+
+    nnet::dense<data_T, typename CONFIG_T::accum_dense_t, typename CONFIG_T::mult_config1>(data, tmpres, param, param_b);
+    nnet::gru_static_recurrent<typename CONFIG_T::accum_dense_t, res_T, CONFIG_T>(reset_state, tmpres, h_newstate, param_zr, param_br);
+}
+
 
 
 template <class data_T, class res_T, typename CONFIG_T>
@@ -506,6 +576,7 @@ void gru_stack(data_T data[CONFIG_T::n_sequence * CONFIG_T::n_in], res_T res[CON
                typename CONFIG_T::weight_t param_zr[CONFIG_T::n_state * 3 * CONFIG_T::n_state],
                typename CONFIG_T::bias_t param_b[CONFIG_T::n_state * 3],
                typename CONFIG_T::bias_t param_br[CONFIG_T::n_state * 3]) {
+    static_assert(CONFIG_T::n_batch == 1, "Batched GRU (n_batch > 1) is only implemented for io_array_stream");
 
     res_T h_state[CONFIG_T::n_state];
     data_T data_in[CONFIG_T::n_in];
@@ -548,6 +619,7 @@ void gru_stack(data_T data[CONFIG_T::n_sequence * CONFIG_T::n_in], init_T initia
                typename CONFIG_T::weight_t param_zr[CONFIG_T::n_state * 3 * CONFIG_T::n_state],
                typename CONFIG_T::bias_t param_b[CONFIG_T::n_state * 3],
                typename CONFIG_T::bias_t param_br[CONFIG_T::n_state * 3]) {
+    static_assert(CONFIG_T::n_batch == 1, "Batched GRU (n_batch > 1) is only implemented for io_array_stream");
 
     res_T h_state[CONFIG_T::n_state];
     data_T data_in[CONFIG_T::n_in];
@@ -597,6 +669,7 @@ void gru_stack(hls::stream<data_T> &data_stream, hls::stream<res_T> &res_stream,
                typename CONFIG_T::weight_t param_zr[CONFIG_T::n_state * 3 * CONFIG_T::n_state],
                typename CONFIG_T::bias_t param_b[CONFIG_T::n_state * 3],
                typename CONFIG_T::bias_t param_br[CONFIG_T::n_state * 3]) {
+    static_assert(CONFIG_T::n_batch == 1, "Batched GRU (n_batch > 1) is only implemented for io_array_stream");
 
     typename res_T::value_type h_newstate[CONFIG_T::n_state];
     #pragma HLS ARRAY_PARTITION variable=h_newstate complete
@@ -651,6 +724,256 @@ DataPropagation:
 }
 
 
+// Timestep loop of the pipelined implementation. The input projection does not depend on
+// h(t-1), so the projection of step t+1 is issued in the same iteration as the recurrent
+// half of step t and only the recurrent half stays on the loop-carried path.
+template<class data_T, class res_T, typename CONFIG_T>
+  void gru_propagate_pipelined(
+      bool reset_state,
+      hls::stream<data_T> data_stream[CONFIG_T::n_in],
+      hls::stream<res_T>  res_stream[CONFIG_T::n_out],
+      res_T  h_newstate[CONFIG_T::n_state],
+      typename CONFIG_T::weight_t     param   [CONFIG_T::n_state*3*CONFIG_T::n_in],
+      typename CONFIG_T::weight_t     param_zr[CONFIG_T::n_state*3*CONFIG_T::n_state],
+      typename CONFIG_T::bias_t       param_b [CONFIG_T::n_state*3],
+      typename CONFIG_T::bias_t       param_br [CONFIG_T::n_state*3]
+      ) {
+    // Same accumulator type as the serial gru_static / gru datapath, so both modes are bit-exact
+    typedef typename std::conditional<CONFIG_T::use_static, typename CONFIG_T::accum_dense_t,
+                                      typename CONFIG_T::accum_t>::type proj_T;
+
+    data_T data_in[CONFIG_T::n_in];
+    #pragma HLS ARRAY_RESHAPE variable=data_in complete
+    proj_T proj_cur[CONFIG_T::n_state*3];
+    #pragma HLS ARRAY_PARTITION variable=proj_cur complete
+    proj_T proj_next[CONFIG_T::n_state*3];
+    #pragma HLS ARRAY_PARTITION variable=proj_next complete
+
+    DataPackFirst: for (int i_pack = 0; i_pack < CONFIG_T::n_in; i_pack++) {
+        #pragma HLS UNROLL
+        data_in[i_pack] = data_stream[i_pack].read();
+    }
+    nnet::dense<data_T, proj_T, typename CONFIG_T::mult_config1>(data_in, proj_next, param, param_b);
+
+    DataPropagation: for(int i_in = 0; i_in < CONFIG_T::n_sequence; i_in++) {
+      #pragma HLS PIPELINE II=CONFIG_T::recurrent_ii
+      for (int i_proj = 0; i_proj < CONFIG_T::n_state*3; i_proj++) {
+          #pragma HLS UNROLL
+          proj_cur[i_proj] = proj_next[i_proj];
+      }
+      if (i_in < CONFIG_T::n_sequence - 1) {
+          DataPack: for (int i_pack = 0; i_pack < CONFIG_T::n_in; i_pack++) {
+              #pragma HLS UNROLL
+              data_in[i_pack] = data_stream[i_pack].read();
+          }
+          nnet::dense<data_T, proj_T, typename CONFIG_T::mult_config1>(data_in, proj_next, param, param_b);
+      }
+      if (CONFIG_T::use_static)
+        nnet::gru_static_recurrent<proj_T, res_T, CONFIG_T>(reset_state, proj_cur, h_newstate, param_zr, param_br);
+      else
+        nnet::gru_recurrent<proj_T, res_T, CONFIG_T>(proj_cur, h_newstate, param_zr, param_br);
+      if (CONFIG_T::n_sequence_out > 1){
+        ResPack_sequences: for (int i_pack = 0; i_pack < CONFIG_T::n_out; i_pack++) {
+            #pragma HLS UNROLL
+            res_stream[i_pack].write(h_newstate[i_pack]);
+        }
+      }
+      reset_state = false;
+    }
+
+    if (CONFIG_T::n_sequence_out == 1){
+        ResPack: for (int i_pack = 0; i_pack < CONFIG_T::n_out; i_pack++) {
+            #pragma HLS UNROLL
+            res_stream[i_pack].write(h_newstate[i_pack]);
+        }
+    }
+}
+
+// Input projection pass of the precomputed implementation: Wx*x(t)+b for every timestep,
+// independent of the hidden state, so it runs ahead of the recurrent core. The 3*n_state values of a
+// timestep travel as one wide element.
+template<class data_T, class proj_T, typename CONFIG_T>
+  void gru_input_projection(
+      hls::stream<data_T> data_stream[CONFIG_T::n_in],
+      hls::stream<array<proj_T, CONFIG_T::n_state*3> > &proj_stream,
+      typename CONFIG_T::weight_t     param   [CONFIG_T::n_state*3*CONFIG_T::n_in],
+      typename CONFIG_T::bias_t       param_b [CONFIG_T::n_state*3]
+      ) {
+    data_T data_in[CONFIG_T::n_in];
+    #pragma HLS ARRAY_RESHAPE variable=data_in complete
+    proj_T proj[CONFIG_T::n_state*3];
+    #pragma HLS ARRAY_PARTITION variable=proj complete
+
+    InputProjection: for(int i_in = 0; i_in < CONFIG_T::n_sequence; i_in++) {
+      #pragma HLS PIPELINE II=CONFIG_T::mult_config1::reuse_factor
+      DataPack: for (int i_pack = 0; i_pack < CONFIG_T::n_in; i_pack++) {
+          #pragma HLS UNROLL
+          data_in[i_pack] = data_stream[i_pack].read();
+      }
+      nnet::dense<data_T, proj_T, typename CONFIG_T::mult_config1>(data_in, proj, param, param_b);
+      array<proj_T, CONFIG_T::n_state*3> proj_pack;
+      PRAGMA_DATA_PACK(proj_pack)
+      ProjPack: for (int i_proj = 0; i_proj < CONFIG_T::n_state*3; i_proj++) {
+          #pragma HLS UNROLL
+          proj_pack[i_proj] = proj[i_proj];
+      }
+      proj_stream.write(proj_pack);
+    }
+}
+
+// Recurrent core of the precomputed implementation: only Wh*h(t-1) and the gates remain
+// inside the timestep loop.
+template<class proj_T, class res_T, typename CONFIG_T>
+  void gru_recurrent_core(
+      bool reset_state,
+      hls::stream<array<proj_T, CONFIG_T::n_state*3> > &proj_stream,
+      hls::stream<res_T>  res_stream[CONFIG_T::n_out],
+      res_T  h_init[CONFIG_T::n_state],
+      typename CONFIG_T::weight_t     param_zr[CONFIG_T::n_state*3*CONFIG_T::n_state],
+      typename CONFIG_T::bias_t       param_br [CONFIG_T::n_state*3]
+      ) {
+    res_T  h_newstate[CONFIG_T::n_state];
+    #pragma HLS ARRAY_PARTITION variable=h_newstate complete
+    for(int ii = 0; ii < CONFIG_T::n_state; ii++) {
+        #pragma HLS UNROLL
+        h_newstate[ii] = h_init[ii];
+    }
+
+    proj_T proj[CONFIG_T::n_state*3];
+    #pragma HLS ARRAY_PARTITION variable=proj complete
+
+    DataPropagation: for(int i_in = 0; i_in < CONFIG_T::n_sequence; i_in++) {
+      #pragma HLS PIPELINE II=CONFIG_T::recurrent_ii
+      array<proj_T, CONFIG_T::n_state*3> proj_pack = proj_stream.read();
+      ProjUnpack: for (int i_proj = 0; i_proj < CONFIG_T::n_state*3; i_proj++) {
+          #pragma HLS UNROLL
+          proj[i_proj] = proj_pack[i_proj];
+      }
+      if (CONFIG_T::use_static)
+        nnet::gru_static_recurrent<proj_T, res_T, CONFIG_T>(reset_state, proj, h_newstate, param_zr, param_br);
+      else
+        nnet::gru_recurrent<proj_T, res_T, CONFIG_T>(proj, h_newstate, param_zr, param_br);
+      if (CONFIG_T::n_sequence_out > 1){
+        ResPack_sequences: for (int i_pack = 0; i_pack < CONFIG_T::n_out; i_pack++) {
+            #pragma HLS UNROLL
+            res_stream[i_pack].write(h_newstate[i_pack]);
+        }
+      }
+      reset_state = false;
+    }
+
+    if (CONFIG_T::n_sequence_out == 1){
+        ResPack: for (int i_pack = 0; i_pack < CONFIG_T::n_out; i_pack++) {
+            #pragma HLS UNROLL
+            res_stream[i_pack].write(h_newstate[i_pack]);
+        }
+    }
+}
+
+template<class data_T, class res_T, typename CONFIG_T>
+  void gru_propagate_precomputed(
+      bool reset_state,
+      hls::stream<data_T> data_stream[CONFIG_T::n_in],
+      hls::stream<res_T>  res_stream[CONFIG_T::n_out],
+      res_T  h_newstate[CONFIG_T::n_state],
+      typename CONFIG_T::weight_t     param   [CONFIG_T::n_state*3*CONFIG_T::n_in],
+      typename CONFIG_T::weight_t     param_zr[CONFIG_T::n_state*3*CONFIG_T::n_state],
+      typename CONFIG_T::bias_t       param_b [CONFIG_T::n_state*3],
+      typename CONFIG_T::bias_t       param_br [CONFIG_T::n_state*3]
+      ) {
+    #pragma HLS DATAFLOW
+    typedef typename std::conditional<CONFIG_T::use_static, typename CONFIG_T::accum_dense_t,
+                                      typename CONFIG_T::accum_t>::type proj_T;
+
+    // One wide FIFO: the projection of timestep t+1 overlaps the core on timestep t, and as the core is the
+    // slower process the projection never needs to run further ahead
+    hls::stream<array<proj_T, CONFIG_T::n_state*3> > proj_stream("proj_stream");
+    #pragma HLS STREAM variable=proj_stream depth=2
+
+    nnet::gru_input_projection<data_T, proj_T, CONFIG_T>(data_stream, proj_stream, param, param_b);
+    nnet::gru_recurrent_core<proj_T, res_T, CONFIG_T>(reset_state, proj_stream, res_stream, h_newstate, param_zr, param_br);
+}
+
+// Multi-trial core: n_batch independent sequences share one recurrent datapath. Streams carry the
+// trials interleaved per timestep, (t0,b0) (t0,b1) ... (t1,b0) ..., so consecutive pipeline
+// iterations belong to different trials and h(t-1) of a trial is needed only n_batch iterations
+// later. Outputs (and initial states) use the same trial order.
+template<class data_T, class init_T, class res_T, typename CONFIG_T>
+  void gru_propagate_batched(
+      hls::stream<data_T> data_stream[CONFIG_T::n_in],
+      hls::stream<init_T> initial_state[CONFIG_T::n_state],
+      hls::stream<res_T>  res_stream[CONFIG_T::n_out],
+      typename CONFIG_T::weight_t     param   [CONFIG_T::n_state*3*CONFIG_T::n_in],
+      typename CONFIG_T::weight_t     param_zr[CONFIG_T::n_state*3*CONFIG_T::n_state],
+      typename CONFIG_T::bias_t       param_b [CONFIG_T::n_state*3],
+      typename CONFIG_T::bias_t       param_br [CONFIG_T::n_state*3]
+      ) {
+    typedef typename std::conditional<CONFIG_T::use_static, typename CONFIG_T::accum_dense_t,
+                                      typename CONFIG_T::accum_t>::type proj_T;
+
+    res_T h_batch[CONFIG_T::n_batch][CONFIG_T::n_state];
+    #pragma HLS ARRAY_PARTITION variable=h_batch complete dim=2
+
+    InitBatch: for (int i_b = 0; i_b < CONFIG_T::n_batch; i_b++) {
+        for(int ii = 0; ii < CONFIG_T::n_state; ii++) {
+            #pragma HLS UNROLL
+            if (CONFIG_T::use_initial==1)
+                h_batch[i_b][ii] = initial_state[ii].read();
+            else
+                h_batch[i_b][ii] = 0;
+        }
+    }
+
+    data_T data_in[CONFIG_T::n_in];
+    #pragma HLS ARRAY_RESHAPE variable=data_in complete
+    proj_T proj[CONFIG_T::n_state*3];
+    #pragma HLS ARRAY_PARTITION variable=proj complete
+    res_T h_trial[CONFIG_T::n_state];
+    #pragma HLS ARRAY_PARTITION variable=h_trial complete
+
+    DataPropagation: for(int i_in = 0; i_in < CONFIG_T::n_sequence; i_in++) {
+      TrialRoundRobin: for (int i_b = 0; i_b < CONFIG_T::n_batch; i_b++) {
+        #pragma HLS PIPELINE II=CONFIG_T::recurrent_ii
+        #pragma HLS DEPENDENCE variable=h_batch inter distance=CONFIG_T::n_batch true
+        DataPack: for (int i_pack = 0; i_pack < CONFIG_T::n_in; i_pack++) {
+            #pragma HLS UNROLL
+            data_in[i_pack] = data_stream[i_pack].read();
+        }
+        nnet::dense<data_T, proj_T, typename CONFIG_T::mult_config1>(data_in, proj, param, param_b);
+
+        for (int ii = 0; ii < CONFIG_T::n_state; ii++) {
+            #pragma HLS UNROLL
+            h_trial[ii] = h_batch[i_b][ii];
+        }
+        if (CONFIG_T::use_static)
+          nnet::gru_static_step<proj_T, res_T, CONFIG_T>(proj, h_trial, param_zr, param_br);
+        else
+          nnet::gru_recurrent<proj_T, res_T, CONFIG_T>(proj, h_trial, param_zr, param_br);
+        for (int ii = 0; ii < CONFIG_T::n_state; ii++) {
+            #pragma HLS UNROLL
+            h_batch[i_b][ii] = h_trial[ii];
+        }
+
+        if (CONFIG_T::n_sequence_out > 1){
+          ResPack_sequences: for (int i_pack = 0; i_pack < CONFIG_T::n_out; i_pack++) {
+              #pragma HLS UNROLL
+              res_stream[i_pack].write(h_trial[i_pack]);
+          }
+        }
+      }
+    }
+
+    if (CONFIG_T::n_sequence_out == 1){
+        ResBatch: for (int i_b = 0; i_b < CONFIG_T::n_batch; i_b++) {
+            #pragma HLS PIPELINE
+            ResPack: for (int i_pack = 0; i_pack < CONFIG_T::n_out; i_pack++) {
+                #pragma HLS UNROLL
+                res_stream[i_pack].write(h_batch[i_b][i_pack]);
+            }
+        }
+    }
+}
+
 template<class data_T, class init_T,class res_T, typename CONFIG_T>
   void gru_stack_array(
       hls::stream<data_T> data_stream[CONFIG_T::n_in],
@@ -662,6 +985,11 @@ template<class data_T, class init_T,class res_T, typename CONFIG_T>
       typename CONFIG_T::bias_t       param_br [CONFIG_T::n_state*3]
       ) {
 
+    if (CONFIG_T::n_batch > 1) {
+        nnet::gru_propagate_batched<data_T, init_T, res_T, CONFIG_T>(data_stream, initial_state, res_stream, param, param_zr, param_b, param_br);
+        return;
+    }
+
     res_T  h_newstate[CONFIG_T::n_state];
     #pragma HLS ARRAY_PARTITION variable=h_newstate complete
     
@@ -681,6 +1009,15 @@ template<class data_T, class init_T,class res_T, typename CONFIG_T>
     #pragma HLS ARRAY_RESHAPE variable=data_in complete
     bool reset_state = true;
 
+    if (CONFIG_T::implementation == recurrent_implementation::pipelined) {
+        nnet::gru_propagate_pipelined<data_T, res_T, CONFIG_T>(reset_state, data_stream, res_stream, h_newstate, param, param_zr, param_b, param_br);
+        return;
+    }
+    if (CONFIG_T::implementation == recurrent_implementation::precomputed) {
+        nnet::gru_propagate_precomputed<data_T, res_T, CONFIG_T>(reset_state, data_stream, res_stream, h_newstate, param, param_zr, param_b, param_br);
+        return;
+    }
+
     DataPropagation: for(int i_in = 0; i_in < CONFIG_T::n_sequence; i_in++) {
       if (CONFIG_T::n_sequence*CONFIG_T::n_in / CONFIG_T::n_in > 1) {
           // #pragma HLS PIPELINE
@@ -21,6 +21,11 @@ template<class data_T, class init_T, class res_T, typename CONFIG_T>
       typename CONFIG_T::bias_t       param_br [CONFIG_T::n_state*3]
       ) {
 
+    if (CONFIG_T::n_batch > 1) {
+        nnet::gru_propagate_batched<data_T, init_T, res_T, CONFIG_T>(data_stream, initial_state, res_stream, param, param_zr, param_b, param_br);
+        return;
+    }
+
     res_T  h_newstate[CONFIG_T::n_state];
     #pragma HLS ARRAY_PARTITION variable=h_newstate complete
     
@@ -40,6 +45,15 @@ template<class data_T, class init_T, class res_T, typename CONFIG_T>
     #pragma HLS ARRAY_RESHAPE variable=data_in complete
     bool reset_state = true;
 
+    if (CONFIG_T::implementation == recurrent_implementation::pipelined) {
+        nnet::gru_propagate_pipelined<data_T, res_T, CONFIG_T>(reset_state, data_stream, res_stream, h_newstate, param, param_zr, param_b, param_br);
+        return;
+    }
+    if (CONFIG_T::implementation == recurrent_implementation::precomputed) {
+        nnet::gru_propagate_precomputed<data_T, res_T, CONFIG_T>(reset_state, data_stream, res_stream, h_newstate, param, param_zr, param_b, param_br);
+        return;
+    }
+
     DataPropagation: for(int i_in = 0; i_in < CONFIG_T::n_sequence; i_in++) {
       if (CONFIG_T::n_sequence*CONFIG_T::n_in / CONFIG_T::n_in > 1) {
           // #pragma HLS PIPELINE
@@ -80,6 +94,14 @@ template<class data_T, class res_T, typename CONFIG_T>
       typename CONFIG_T::bias_t       param_br [CONFIG_T::n_state*3]
       ) {
 
+    if (CONFIG_T::n_batch > 1) {
+        // Every trial starts from a zero state on every call, the state is not kept between calls as with
+        // use_static, and the initial state stream is never read
+        hls::stream<res_T> no_initial_state[CONFIG_T::n_state];
+        nnet::gru_propagate_batched<data_T, res_T, res_T, CONFIG_T>(data_stream, no_initial_state, res_stream, param, param_zr, param_b, param_br);
+        return;
+    }
+
     res_T  h_newstate[CONFIG_T::n_state];
     #pragma HLS ARRAY_PARTITION variable=h_newstate complete
     
@@ -92,6 +114,15 @@ template<class data_T, class res_T, typename CONFIG_T>
     #pragma HLS ARRAY_RESHAPE variable=data_in complete
     bool reset_state = false;
 
+    if (CONFIG_T::implementation == recurrent_implementation::pipelined) {
+        nnet::gru_propagate_pipelined<data_T, res_T, CONFIG_T>(reset_state, data_stream, res_stream, h_newstate, param, param_zr, param_b, param_br);
+        return;
+    }
+    if (CONFIG_T::implementation == recurrent_implementation::precomputed) {
+        nnet::gru_propagate_precomputed<data_T, res_T, CONFIG_T>(reset_state, data_stream, res_stream, h_newstate, param, param_zr, param_b, param_br);
+        return;
+    }
+
     DataPropagation: for(int i_in = 0; i_in < CONFIG_T::n_sequence; i_in++) {
       if (CONFIG_T::n_sequence*CONFIG_T::n_in / CONFIG_T::n_in > 1) {
           // #pragma HLS PIPELINE
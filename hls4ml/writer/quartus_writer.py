@@ -260,9 +260,9 @@ class QuartusWriter(Writer):
                         newline += '    ' + func + '\n'
                         if model.config.trace_output and layer.get_attr('trace', False):
                             newline += '#ifndef HLS_SYNTHESIS\n'
-                            for var in vars:
+                            for trace_name, var in layer.get_trace_variables():
                                 newline += '    nnet::save_layer_output<{}>({}, "{}", {});\n'.format(
-                                    var.type.name, var.name, layer.name, var.size_cpp()
+                                    var.type.name, var.name, trace_name, var.size_cpp()
                                 )
                             newline += '#endif\n'
                         newline += '\n'
@@ -853,12 +853,11 @@ class QuartusWriter(Writer):
                 for layer in model.get_layers():
                     func = layer.get_attr('function_cpp')
                     if func and model.config.trace_output and layer.get_attr('trace', False):
-                        vars = layer.get_variables()
-                        for var in vars:
+                        for trace_name, var in layer.get_trace_variables():
                             newline += (
                                 indent
                                 + 'nnet::trace_outputs->insert(std::pair<std::string, void *>('
-                                + f'"{layer.name}", (void *) malloc({var.size_cpp()} * element_size)));\n'
+                                + f'"{trace_name}", (void *) malloc({var.size_cpp()} * element_size)));\n'
                             )
 
             else:
@@ -1,5 +1,7 @@
 import glob
+import math
 import os
+import struct
 import tarfile
 from collections import OrderedDict
 from shutil import copyfile, copytree, rmtree
@@ -7,11 +9,59 @@ from shutil import copyfile, copytree, rmtree
 import numpy as np
 import yaml
 
+from hls4ml.model.types import FixedPrecisionType
 from hls4ml.writer.writers import Writer
 
 config_filename = 'hls4ml_config.yml'
 
 
+# Lookup table values as the init_*_table functions of nnet_utils compute them, before the conversion to the table
+# type, so the emitted tables are the ones C simulation would build. float is rounded as the C++ does.
+def _float32(x):
+    return struct.unpack('f', struct.pack('f', x))[0]
+
+
+def _sigmoid_table(table_size, input_precision):
+    # init_sigmoid_table: 1 / (1 + e^-x) on [-8, 8)
+    values = []
+    for i in range(table_size):
+        x = _float32(2 * 8.0 * (i - table_size / 2.0) / table_size)
+        values.append(_float32(1.0 / _float32(1 + _float32(math.exp(-x)))))
+    return values
+
+
+def _tanh_table(table_size, input_precision):
+    # init_tanh_table: tanh(x) on [-4, 4)
+    return [math.tanh(_float32(2 * 4.0 * (i - table_size / 2.0) / table_size)) for i in range(table_size)]
+
+
+def _explogvar_table(table_size, input_precision):
+    # init_explogvar_table: exp(0.5 * x) at the input values whose top log2(table_size) bits are the index
+    n_bits = int(math.ceil(math.log2(table_size)))
+    values = []
+    for i in range(table_size):
+        index = i - table_size if input_precision.signed and i >= table_size // 2 else i
+        x = _float32(index * 2.0 ** (input_precision.integer - n_bits))
+        values.append(_float32(math.exp(0.5 * x)))
+    return values
+
+
+def _normal_quantile_table(table_size, input_precision):
+    # init_normal_quantile_table: bisection on the normal CDF at the centres of the slices of the upper half
+    values = []
+    for i in range(table_size):
+        p = _float32(0.5 + (i + 0.5) / (2.0 * table_size))
+        lo, hi = -16.0, 16.0
+        for _ in range(64):
+            mid = 0.5 * (lo + hi)
+            if 0.5 * math.erfc(-mid / math.sqrt(2.0)) < p:
+                lo = mid
+            else:
+                hi = mid
+        values.append(_float32(0.5 * (lo + hi)))
+    return values
+
+
 class VivadoWriter(Writer):
     def print_array_to_cpp(self, var, odir, write_txt_file=True):
         """Write a weights array to C++ header files.
@@ -19,12 +69,16 @@ class VivadoWriter(Writer):
         Args:
             var (WeightVariable): Weight to write
             odir (str): Output directory
-            write_txt_file (bool, optional): Write txt files in addition to .h files. Defaults to True.
+            write_txt_file (bool, optional): Write txt files in addition to .h files. Also writes the binary
+                .bin file for uncompressed weights, which C simulation loads instead of the .txt file unless the
+                .txt file was modified later. Defaults to True.
         """
 
         h_file = open(f"{odir}/firmware/weights/{var.name}.h", "w")
         if write_txt_file:
             txt_file = open(f"{odir}/firmware/weights/{var.name}.txt", "w")
+        write_bin_file = write_txt_file and getattr(var, 'weight_class', 'WeightVariable') == 'WeightVariable'
+        bin_values = []
 
         # meta data
         h_file.write(f"//Numpy array shape {var.shape}\n")
@@ -51,6 +105,8 @@ class VivadoWriter(Writer):
             h_file.write(sep + x)
             if write_txt_file:
                 txt_file.write(sep + x)
+            if write_bin_file:
+                bin_values.append(float(x))
             sep = ", "
         h_file.write("};\n")
         if write_txt_file:
@@ -59,6 +115,80 @@ class VivadoWriter(Writer):
         h_file.write("\n#endif\n")
         h_file.close()
 
+        if write_bin_file:
+            self._write_weights_bin(f"{odir}/firmware/weights/{var.name}.bin", var.shape, bin_values)
+
+    @staticmethod
+    def _write_weights_bin(path, shape, values):
+        """Write weights in the binary format read by nnet::load_weights_from_bin.
+
+        The values are the ones written to the .txt file, stored as float64 after a header holding the dtype,
+        shape and a checksum of the payload.
+        """
+        payload = np.asarray(values, dtype='<f8')
+        checksum = int(np.sum(payload.view('<u8'), dtype=np.uint64))
+        with open(path, 'wb') as bin_file:
+            bin_file.write(struct.pack('<8sIIQQ', b'HLS4MLWB', 1, len(shape), payload.size, checksum))
+            bin_file.write(struct.pack(f'<{len(shape)}Q', *shape))
+            bin_file.write(payload.tobytes())
+
+    @staticmethod
+    def _lut_type_cpp(precision):
+        """Spell out an ap_fixed type with all its parameters, so equal types give equal strings."""
+        precision = getattr(precision, 'precision', precision)
+        if not isinstance(precision, FixedPrecisionType):
+            return None
+        rounding_mode = precision.rounding_mode if precision.rounding_mode is not None else 'TRN'
+        saturation_mode = precision.saturation_mode if precision.saturation_mode is not None else 'WRAP'
+        saturation_bits = precision.saturation_bits if precision.saturation_bits is not None else 0
+        return 'ap_{}fixed<{},{},AP_{},AP_{},{}>'.format(
+            '' if precision.signed else 'u',
+            precision.width,
+            precision.integer,
+            rounding_mode,
+            saturation_mode,
+            saturation_bits,
+        )
+
+    def _lookup_tables(self, model):
+        """Collect the lookup tables of the model that C simulation would otherwise compute at startup.
+
+        Args:
+            model (ModelGraph): the hls4ml model.
+
+        Returns:
+            dict: The table values keyed by the nnet::lut_data parameters (fill functor, table type, table size,
+                input type).
+        """
+        requests = []
+        for layer in model.get_layers():
+            table_t = layer.get_attr('table_t')
+            table_size = layer.get_attr('table_size')
+            if table_t is not None and table_size is not None:
+                for activation in [layer.get_attr('activation'), layer.get_attr('recurrent_activation')]:
+                    if activation == 'sigmoid':
+                        requests.append(('sigmoid_lut', table_t, table_size, None, _sigmoid_table))
+                    elif activation == 'tanh':
+                        requests.append(('tanh_lut', table_t, table_size, None, _tanh_table))
+            if layer.class_name == 'GaussianSample':
+                if layer.get_attr('exp_implementation') == 'table':
+                    exp_table_t = layer.get_attr('exp_table_t')
+                    log_var_t = layer.get_input_variable(layer.inputs[1]).type.precision
+                    requests.append(('explogvar_lut', exp_table_t, table_size, log_var_t, _explogvar_table))
+                if layer.get_attr('rng_engine') == 'inverse_cdf':
+                    requests.append(('normal_quantile_lut', layer.get_attr('rnd_t'), 1024, None, _normal_quantile_table))
+
+        tables = OrderedDict()
+        for fill, table_t, table_size, input_t, table_function in requests:
+            table_cpp = self._lut_type_cpp(table_t)
+            input_cpp = 'void' if input_t is None else self._lut_type_cpp(input_t)
+            if table_cpp is None or input_cpp is None:
+                continue
+            key = (fill, table_cpp, table_size, input_cpp)
+            if key not in tables:
+                tables[key] = table_function(table_size, getattr(input_t, 'precision', input_t))
+        return tables
+
     def write_project_dir(self, model):
         """Write the base project directory
 
@@ -102,6 +232,20 @@ class VivadoWriter(Writer):
         elif mode == 'stream':
             return f'#pragma HLS STREAM variable={variable.name} depth={depth}'
 
+    @staticmethod
+    def _make_stream_depth(variable, depth=None, name_suffix=''):
+        """
+        The ring buffer C-simulation model of hls::stream (HLS_STREAM_RING_BUFFER) is sized by the stream depth.
+        Without an explicit depth, the stream holds a whole sample, as the top-level streams of the bridge must.
+        """
+
+        if depth is None:
+            depth = int(np.prod(variable.shape)) // variable.shape[-1]
+        line = '#ifdef HLS_STREAM_RING_BUFFER\n'
+        line += f'    hls::set_depth({variable.name}{name_suffix}, {depth});\n'
+        line += '#endif\n'
+        return line
+
     def write_project_cpp(self, model):
         """Write the main architecture source file (myproject.cpp)
 
@@ -154,7 +298,7 @@ class VivadoWriter(Writer):
                                 w.type.name, w.data_length, w.name, w.name
                             )
                         else:
-                            newline += indent + '    nnet::load_weights_from_txt<{}, {}>({}, "{}.txt");\n'.format(
+                            newline += indent + '    nnet::load_weights<{}, {}>({}, "{}");\n'.format(
                                 w.type.name, w.data_length, w.name, w.name
                             )
 
@@ -190,32 +334,90 @@ class VivadoWriter(Writer):
 
             elif '// hls-fpga-machine-learning insert layers' in line:
                 newline = line + '\n'
+                io_type = model.config.get_config_value('IOType')
+                # In C simulation, the layers of a streaming design can run as concurrent threads (see
+                # NNET_DATAFLOW_PROCESS). Profiling times every layer on its own, so it keeps them sequential.
+                dataflow_threads = io_type in ['io_stream', 'io_array_stream'] and not model.config.profile_output
+                # The region joins its threads when it goes out of scope, so it is declared after every stream and
+                # trace the layers use: those are then destroyed only once the threads are done with them
+                decls = ''
+                calls = ''
+                fifos = []
                 for layer in model.get_layers():
                     vars = layer.get_variables()
                     for var in vars:
                         if var not in model_inputs and var not in model_outputs:
                             def_cpp = var.definition_cpp()
                             if def_cpp is not None:
-                                newline += '    ' + def_cpp + ';\n'
+                                decls += '    ' + def_cpp + ';\n'
                                 if var.pragma:
-                                    newline += '    ' + self._make_array_pragma(var) + '\n'
+                                    decls += '    ' + self._make_array_pragma(var) + '\n'
+                                    if type(var.pragma) is tuple and var.pragma[0] == 'stream':
+                                        decls += self._make_stream_depth(var, depth=var.pragma[1])
+                                        fifos.append(var)
                     func = layer.get_attr('function_cpp', None)
+                    trace = func and model.config.trace_output and layer.get_attr('trace', False)
+                    if trace and io_type in ['io_stream', 'io_array_stream']:
+                        # Streams are traced as the layer writes them, see nnet::stream_trace
+                        decls += '#ifndef __SYNTHESIS__\n'
+                        for trace_name, var in layer.get_trace_variables():
+                            lanes = f'{var.shape[-1]}, ' if io_type == 'io_array_stream' else ''
+                            decls += '    nnet::stream_trace<{}> trace_{}({}, {}"{}", {});\n'.format(
+                                var.type.name, var.name, var.name, lanes, trace_name, var.size_cpp()
+                            )
+                        decls += '#endif\n'
                     if func:
+                        if model.config.profile_output:
+                            cost = model.config.backend.get_layer_cost(layer)
+                            calls += '#ifndef __SYNTHESIS__\n'
+                            calls += '    static nnet::layer_profile profile{}("{}", {}, {}, {});\n'.format(
+                                layer.index, layer.name, cost['trip_count'], cost['macs'], cost['cycles']
+                            )
+                            calls += f'    nnet::layer_timer timer{layer.index}(profile{layer.index});\n'
+                            calls += '#endif\n'
                         func = [func]
+                        if dataflow_threads:
+                            func = ['NNET_DATAFLOW_PROCESS(dataflow, ' + f.rstrip().rstrip(';') + ');' for f in func]
                         if len(func) == 1:
-                            newline += '    ' + func[0] + ' // ' + layer.name + '\n'
+                            calls += '    ' + func[0] + ' // ' + layer.name + '\n'
                         else:
-                            newline += '// ' + layer.name + '\n'
+                            calls += '// ' + layer.name + '\n'
                             for line in func:
-                                newline += '    ' + line + '\n'
-                        if model.config.trace_output and layer.get_attr('trace', False):
-                            newline += '#ifndef __SYNTHESIS__\n'
-                            for var in vars:
-                                newline += '    nnet::save_layer_output<{}>({}, "{}", {});\n'.format(
-                                    var.type.name, var.name, layer.name, var.size_cpp()
+                                calls += '    ' + line + '\n'
+                        if model.config.profile_output:
+                            calls += '#ifndef __SYNTHESIS__\n'
+                            calls += f'    timer{layer.index}.stop();\n'
+                            calls += '#endif\n'
+                        if trace and io_type == 'io_parallel':
+                            calls += '#ifndef __SYNTHESIS__\n'
+                            for trace_name, var in layer.get_trace_variables():
+                                calls += '    nnet::save_layer_output<{}>({}, "{}", {});\n'.format(
+                                    var.type.name, var.name, trace_name, var.size_cpp()
                                 )
-                            newline += '#endif\n'
-                        newline += '\n'
+                            calls += '#endif\n'
+                        calls += '\n'
+                    if not dataflow_threads:
+                        newline += decls + calls
+                        decls = ''
+                        calls = ''
+                if dataflow_threads:
+                    newline += decls + '\n'
+                    newline += '#ifdef NNET_DATAFLOW_THREADS\n'
+                    newline += '    nnet::dataflow_region dataflow;\n'
+                    newline += '#endif\n\n'
+                    newline += calls
+                    newline += '#ifdef NNET_DATAFLOW_THREADS\n'
+                    newline += '    dataflow.join();\n'
+                    newline += '#endif\n'
+                if fifos:
+                    # FIFO occupancy profile, see ModelGraph.profile_fifo_depths()
+                    newline += '#ifdef NNET_FIFO_DEPTHS\n'
+                    for var in fifos:
+                        if io_type == 'io_array_stream':
+                            newline += f'    nnet::record_fifo_depth({var.name}, "{var.name}", {var.shape[-1]});\n'
+                        else:
+                            newline += f'    nnet::record_fifo_depth({var.name}, "{var.name}");\n'
+                    newline += '#endif\n'
 
             # Just copy line
             else:
@@ -329,6 +531,23 @@ class VivadoWriter(Writer):
                 for include in sorted(set(sum((layer.get_attr('include_header', []) for layer in model.get_layers()), []))):
                     newline += '#include "%s"\n' % include
 
+            elif '// hls-fpga-machine-learning insert lookup tables' in line:
+                newline = line
+                tables = self._lookup_tables(model)
+                if tables:
+                    newline += 'namespace nnet {\n'
+                    for (fill, table_cpp, table_size, input_cpp), values in tables.items():
+                        newline += f'template <> struct lut_data<{fill}, {table_cpp}, {table_size}, {input_cpp}> {{\n'
+                        newline += '    static const double *values() {\n'
+                        newline += f'        static const double data[{table_size}] = {{\n'
+                        for i in range(0, table_size, 8):
+                            newline += '            ' + ', '.join(repr(v) for v in values[i : i + 8]) + ',\n'
+                        newline += '        };\n'
+                        newline += '        return data;\n'
+                        newline += '    }\n'
+                        newline += '};\n'
+                    newline += '} // namespace nnet\n'
+
             elif '// hls-fpga-machine-learning insert weights' in line:
                 newline = line
                 for layer in model.get_layers():
@@ -536,9 +755,12 @@ class VivadoWriter(Writer):
                 newline += indent + outputs_str + '\n'
             elif '// hls-fpga-machine-learning insert wrapper' in line:
                 dtype = line.split('#', 1)[1].strip()
+                io_type = model.config.get_config_value("IOType")
                 newline = ''
                 for i in model_inputs:
                     newline += indent + '{var};\n'.format(var=i.definition_cpp(name_suffix='_ap'))
+                    if io_type in ['io_stream', 'io_array_stream']:
+                        newline += self._make_stream_depth(i, name_suffix='_ap')
                     if model.config.get_config_value("IOType") == 'io_array_stream':
                         newline += indent + 'nnet::convert_data<{}, {}, {}, {}>({}, {}_ap);\n'.format(
                             dtype, i.type.name, i.shape[-1], i.size_cpp()+'/'+str(i.shape[-1]), i.name, i.name
@@ -551,6 +773,8 @@ class VivadoWriter(Writer):
 
                 for o in model_outputs:
                     newline += indent + '{var};\n'.format(var=o.definition_cpp(name_suffix='_ap'))
+                    if io_type in ['io_stream', 'io_array_stream']:
+                        newline += self._make_stream_depth(o, name_suffix='_ap')
 
                 newline += '\n'
 
@@ -575,17 +799,31 @@ class VivadoWriter(Writer):
                         newline += indent + 'nnet::convert_data<{}, {}, {}>({}_ap, {});\n'.format(
                             o.type.name, dtype, o.size_cpp(), o.name, o.name
                         )
+            elif '// hls-fpga-machine-learning insert batch header' in line:
+                dtype = line.split('#', 1)[1].strip()
+                inputs_str = ', '.join([f'{dtype} *{i.name}' for i in model_inputs])
+                outputs_str = ', '.join([f'{dtype} *{o.name}' for o in model_outputs])
+
+                newline = ''
+                newline += indent + 'size_t n_samples, unsigned n_threads,\n'
+                newline += indent + inputs_str + ',\n'
+                newline += indent + outputs_str + '\n'
+            elif '// hls-fpga-machine-learning insert batch wrapper' in line:
+                dtype = line.split('#', 1)[1].strip()
+                sample_args = ', '.join([f'{v.name} + i * ({v.size_cpp()})' for v in model_inputs + model_outputs])
+                newline = indent + 'nnet::run_batch(n_samples, n_threads, [&](size_t i) {\n'
+                newline += indent * 2 + f'{model.config.get_project_name()}_{dtype}({sample_args});\n'
+                newline += indent + '});\n'
             elif '// hls-fpga-machine-learning insert trace_outputs' in line:
                 newline = ''
                 for layer in model.get_layers():
                     func = layer.get_attr('function_cpp', None)
                     if func and model.config.trace_output and layer.get_attr('trace', False):
-                        vars = layer.get_variables()
-                        for var in vars:
+                        for trace_name, var in layer.get_trace_variables():
                             newline += (
                                 indent
                                 + 'nnet::trace_outputs->insert(std::pair<std::string, void *>('
-                                + f'"{layer.name}", (void *) malloc({var.size_cpp()} * element_size)));\n'
+                                + f'"{trace_name}", (void *) malloc({var.size_cpp()} * element_size)));\n'
                             )
 
             else:
@@ -53,3 +53,56 @@ def test_activations(backend, activation, name, shape, io_type):
     hls_prediction = hls_model.predict(X).reshape(keras_prediction.shape)
 
     np.testing.assert_allclose(hls_prediction, keras_prediction, rtol=2e-2, atol=2e-2)
+
+
+@pytest.mark.parametrize('backend', ['Vivado', 'Vitis'])
+def test_lookup_tables(backend):
+    '''The writer emits the sigmoid and tanh tables to parameters.h, one per distinct table type and size.'''
+    X = np.random.rand(1000, 8) - 0.5
+
+    input = Input(shape=(8,))
+    hidden = Activation('sigmoid', name='sigmoid')(input)
+    hidden = Activation('tanh', name='tanh')(hidden)
+    output = Activation('sigmoid', name='sigmoid_2')(hidden)
+    keras_model = Model(inputs=input, outputs=output)
+
+    hls_config = hls4ml.utils.config_from_keras_model(keras_model, granularity='name')
+    output_dir = str(test_root_path / f'hls4mlprj_activations_lookup_tables_{backend}')
+    hls_model = hls4ml.converters.convert_from_keras_model(
+        keras_model, hls_config=hls_config, io_type='io_parallel', output_dir=output_dir, backend=backend
+    )
+    hls_model.compile()
+
+    with open(f'{output_dir}/firmware/parameters.h') as f:
+        parameters = f.read()
+    assert parameters.count('struct lut_data<sigmoid_lut,') == 1
+    assert parameters.count('struct lut_data<tanh_lut,') == 1
+
+    keras_prediction = keras_model.predict(X)
+    hls_prediction = hls_model.predict(X).reshape(keras_prediction.shape)
+    np.testing.assert_allclose(hls_prediction, keras_prediction, rtol=2e-2, atol=2e-2)
+
+
+@pytest.mark.parametrize('activation', ['sigmoid', 'tanh'])
+@pytest.mark.parametrize('table_ports', [1, 2, 3])
+def test_activations_array_stream_banked(activation, table_ports):
+    '''Banked array-stream tables, read by DIV_ROUNDUP(8, 4) channels per cycle, give the io_parallel results.'''
+    X = 8 * (np.random.rand(1000, 8) - 0.5)
+
+    input = Input(shape=(8,))
+    output = Activation(activation, name='activation')(input)
+    keras_model = Model(inputs=input, outputs=output)
+
+    predictions = {}
+    for io_type in ['io_parallel', 'io_array_stream']:
+        hls_config = hls4ml.utils.config_from_keras_model(keras_model, granularity='name')
+        hls_config['LayerName']['activation']['ReuseFactor'] = 4
+        hls_config['LayerName']['activation']['table_ports'] = table_ports
+        output_dir = str(test_root_path / f'hls4mlprj_activations_banked_{activation}_ports{table_ports}_{io_type}')
+        hls_model = hls4ml.converters.convert_from_keras_model(
+            keras_model, hls_config=hls_config, io_type=io_type, output_dir=output_dir
+        )
+        hls_model.compile()
+        predictions[io_type] = hls_model.predict(X)
+
+    np.testing.assert_array_equal(predictions['io_array_stream'], predictions['io_parallel'])
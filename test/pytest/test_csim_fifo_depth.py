@@ -0,0 +1,99 @@
+import ctypes
+import json
+from pathlib import Path
+
+import numpy as np
+import pytest
+import tensorflow as tf
+from tensorflow.keras.layers import GRU, Activation, Dense, TimeDistributed
+
+import hls4ml
+
+test_root_path = Path(__file__).parent
+
+
+@pytest.mark.parametrize('io_type', ['io_stream', 'io_array_stream'])
+def test_csim_fifo_depth(io_type, monkeypatch):
+    n_sequence = 10
+
+    model = tf.keras.models.Sequential()
+    if io_type == 'io_array_stream':
+        model.add(TimeDistributed(Dense(16), input_shape=(n_sequence, 8), name='dense1'))
+        model.add(Activation('relu', name='relu1'))
+        model.add(TimeDistributed(Dense(4), name='dense2'))
+        input_shape = (n_sequence, 8)
+    else:
+        model.add(Dense(16, input_shape=(8,), name='dense1'))
+        model.add(Activation('relu', name='relu1'))
+        model.add(Dense(4, name='dense2'))
+        input_shape = (8,)
+    model.compile(optimizer='adam', loss='mse')
+
+    X = np.random.uniform(-1, 1, size=(20,) + input_shape)
+
+    config = hls4ml.utils.config_from_keras_model(model, default_precision='ap_fixed<16,6>', granularity='name')
+    output_dir = str(test_root_path / f'hls4mlprj_csim_fifo_depth_{io_type}')
+    hls_model = hls4ml.converters.convert_from_keras_model(
+        model, hls_config=config, output_dir=output_dir, io_type=io_type
+    )
+    hls_model.compile()
+    y_default = hls_model.predict(X)
+    default_depths = {
+        v.name: v.pragma[1] for v in hls_model.output_vars.values() if type(v.pragma) is tuple and v.pragma[0] == 'stream'
+    }
+
+    config['Flows'] = ['vivado:csim_fifo_depth_optimization']
+    hls4ml.model.optimizer.get_optimizer('vivado:csim_fifo_depth_optimization').configure(profiling_input=X)
+    hls_model = hls4ml.converters.convert_from_keras_model(
+        model, hls_config=config, output_dir=output_dir + '_opt', io_type=io_type
+    )
+    hls4ml.model.optimizer.get_optimizer('vivado:csim_fifo_depth_optimization').configure(profiling_input=None)
+
+    assert (Path(output_dir + '_opt') / 'fifo_depths.json').exists()
+    optimized_depths = {
+        v.name: v.pragma[1] for v in hls_model.output_vars.values() if type(v.pragma) is tuple and v.pragma[0] == 'stream'
+    }
+    for name, depth in optimized_depths.items():
+        assert 1 <= depth <= default_depths[name]
+    if io_type == 'io_array_stream':
+        # The layers stream the sequence through, one timestep at a time
+        assert sum(optimized_depths.values()) < sum(default_depths.values())
+
+    # The resized FIFOs are large enough for the layers to run concurrently without deadlock
+    monkeypatch.setenv('HLS4ML_STREAM_RING_BUFFER', '1')
+    monkeypatch.setenv('HLS4ML_DATAFLOW_THREADS', '1')
+    hls_model.compile()
+    np.testing.assert_array_equal(hls_model.predict(X), y_default)
+
+
+def test_csim_fifo_depth_gru(monkeypatch):
+    '''Profile a precomputed GRU longer than the default ring depth, and leave the normal build loaded.'''
+    n_sequence = 73
+
+    model = tf.keras.models.Sequential()
+    model.add(GRU(16, input_shape=(n_sequence, 8), return_sequences=True, name='gru1'))
+    model.add(TimeDistributed(Dense(4), name='dense1'))
+    model.compile(optimizer='adam', loss='mse')
+
+    X = np.random.uniform(-1, 1, size=(5, n_sequence, 8))
+
+    config = hls4ml.utils.config_from_keras_model(model, default_precision='ap_fixed<16,6>', granularity='name')
+    config['LayerName']['gru1']['RecurrentImplementation'] = 'precomputed'
+    output_dir = str(test_root_path / 'hls4mlprj_csim_fifo_depth_gru')
+    hls_model = hls4ml.converters.convert_from_keras_model(
+        model, hls_config=config, output_dir=output_dir, io_type='io_array_stream'
+    )
+    hls_model.compile()
+    y_default = hls_model.predict(X)
+
+    depths = hls_model.profile_fifo_depths(X)
+    assert depths
+
+    # The instrumented threaded library is not left behind: the normal build records no FIFO occupancy
+    np.testing.assert_array_equal(hls_model.predict(X), y_default)
+    filename = str(Path(output_dir) / 'fifo_depths_after.json')
+    write_func = hls_model._top_function_lib.write_fifo_depths
+    write_func.argtypes = [ctypes.c_char_p]
+    write_func(filename.encode('utf-8'))
+    with open(filename) as f:
+        assert json.load(f) == {}
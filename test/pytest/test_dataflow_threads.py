@@ -0,0 +1,119 @@
+from pathlib import Path
+
+import numpy as np
+import pytest
+import tensorflow as tf
+from qkeras import QGRU, QBidirectional, quantized_bits, quantized_sigmoid, quantized_tanh
+from tensorflow.keras.layers import GRU, Activation, Dense
+
+import hls4ml
+
+test_root_path = Path(__file__).parent
+
+
+@pytest.mark.parametrize('io_type', ['io_stream', 'io_array_stream'])
+@pytest.mark.parametrize('ring_buffer', [False, True])
+def test_dataflow_threads(io_type, ring_buffer, monkeypatch):
+    model = tf.keras.models.Sequential()
+    model.add(Dense(16, input_shape=(8,), name='dense1'))
+    model.add(Activation('relu', name='relu1'))
+    model.add(Dense(16, name='dense2'))
+    model.add(Activation('sigmoid', name='sigmoid2'))
+    model.add(Dense(4, name='dense3'))
+    model.compile(optimizer='adam', loss='mse')
+
+    config = hls4ml.utils.config_from_keras_model(model, default_precision='ap_fixed<16,6>')
+    X = np.random.uniform(-1, 1, size=(100, 8))
+
+    if ring_buffer:
+        monkeypatch.setenv('HLS4ML_STREAM_RING_BUFFER', '1')
+
+    predictions = []
+    for threads in [False, True]:
+        if threads:
+            monkeypatch.setenv('HLS4ML_DATAFLOW_THREADS', '1')
+        output_dir = str(
+            test_root_path / f'hls4mlprj_dataflow_threads_{io_type}_ring{int(ring_buffer)}_threads{int(threads)}'
+        )
+        hls_model = hls4ml.converters.convert_from_keras_model(
+            model, hls_config=config, output_dir=output_dir, io_type=io_type
+        )
+        hls_model.compile()
+        predictions.append(hls_model.predict(X))
+
+    # Running the layers as concurrent processes must not change the results
+    np.testing.assert_array_equal(predictions[0], predictions[1])
+
+
+def test_dataflow_threads_long_gru(monkeypatch):
+    '''A precomputed GRU streams its whole input projection through a FIFO inside the kernel, longer than the
+    default depth of the threaded ring.'''
+    n_timesteps = 80
+    model = tf.keras.models.Sequential()
+    model.add(GRU(16, input_shape=(n_timesteps, 8), return_sequences=True, name='gru1'))
+    model.compile(optimizer='adam', loss='mse')
+
+    config = hls4ml.utils.config_from_keras_model(model, default_precision='ap_fixed<16,6>', granularity='name')
+    config['LayerName']['gru1']['RecurrentImplementation'] = 'precomputed'
+    X = np.random.uniform(-1, 1, size=(10, n_timesteps, 8))
+
+    predictions = []
+    for threads in [False, True]:
+        if threads:
+            monkeypatch.setenv('HLS4ML_STREAM_RING_BUFFER', '1')
+            monkeypatch.setenv('HLS4ML_DATAFLOW_THREADS', '1')
+        output_dir = str(test_root_path / f'hls4mlprj_dataflow_threads_long_gru_threads{int(threads)}')
+        hls_model = hls4ml.converters.convert_from_keras_model(
+            model, hls_config=config, output_dir=output_dir, io_type='io_array_stream'
+        )
+        hls_model.compile()
+        predictions.append(hls_model.predict(X))
+
+    np.testing.assert_array_equal(predictions[0], predictions[1])
+
+
+@pytest.mark.parametrize('recurrent', ['gru', 'bidirectional'])
+def test_dataflow_threads_rnn(recurrent, monkeypatch):
+    '''Stacked recurrent layers keep their results when their processes run concurrently.'''
+    input_shape = (8, 6)
+    model = tf.keras.models.Sequential()
+    model.add(GRU(8, input_shape=input_shape, return_sequences=True, name='gru1'))
+    if recurrent == 'gru':
+        model.add(GRU(8, name='gru2'))
+    else:
+        quantizer = quantized_bits(16, 4, alpha=1)
+        model.add(
+            QBidirectional(
+                QGRU(
+                    units=8,
+                    activation=quantized_tanh(16),
+                    recurrent_activation=quantized_sigmoid(16),
+                    kernel_quantizer=quantizer,
+                    recurrent_quantizer=quantizer,
+                    bias_quantizer=quantizer,
+                    state_quantizer=quantizer,
+                    reset_after=True,
+                ),
+                name='bidirectional',
+            )
+        )
+    model.compile(optimizer='adam', loss='mse')
+
+    config = hls4ml.utils.config_from_keras_model(model, default_precision='ap_fixed<16,6>', granularity='name')
+    if recurrent == 'bidirectional':
+        config['LayerName']['bidirectional']['implementation'] = 'streaming'
+    X = np.random.uniform(-1, 1, size=(20, *input_shape))
+
+    predictions = []
+    for threads in [False, True]:
+        if threads:
+            monkeypatch.setenv('HLS4ML_STREAM_RING_BUFFER', '1')
+            monkeypatch.setenv('HLS4ML_DATAFLOW_THREADS', '1')
+        output_dir = str(test_root_path / f'hls4mlprj_dataflow_threads_{recurrent}_threads{int(threads)}')
+        hls_model = hls4ml.converters.convert_from_keras_model(
+            model, hls_config=config, output_dir=output_dir, io_type='io_array_stream'
+        )
+        hls_model.compile()
+        predictions.append(hls_model.predict(X))
+
+    np.testing.assert_array_equal(predictions[0], predictions[1])
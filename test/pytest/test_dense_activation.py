@@ -0,0 +1,75 @@
+from pathlib import Path
+
+import numpy as np
+import pytest
+import tensorflow as tf
+from tensorflow.keras.layers import Dense
+
+import hls4ml
+from hls4ml.backends.vivado.passes.dense_activation import FuseDenseActivation
+
+test_root_path = Path(__file__).parent
+
+
+@pytest.mark.parametrize('activation', ['relu', 'sigmoid', 'tanh', 'exponential'])
+@pytest.mark.parametrize('reuse_factor', [1, 4])
+def test_dense_activation(activation, reuse_factor):
+    n_in = 8
+    n_out = 6
+
+    model = tf.keras.models.Sequential()
+    model.add(Dense(n_out, input_shape=(n_in,), activation=activation, name='dense'))
+    model.compile(optimizer='adam', loss='mse')
+
+    config = hls4ml.utils.config_from_keras_model(model, default_precision='ap_fixed<24,10>', granularity='name')
+    config['LayerName']['dense']['ReuseFactor'] = reuse_factor
+    output_dir = str(test_root_path / f'hls4mlprj_dense_activation_{activation}_rf{reuse_factor}')
+    hls_model = hls4ml.converters.convert_from_keras_model(
+        model, hls_config=config, output_dir=output_dir, io_type='io_array_stream'
+    )
+    hls_model.compile()
+
+    # The activation is applied by the dense layer itself
+    assert [layer.class_name for layer in hls_model.get_layers()] == ['Input', 'DenseActivation']
+
+    X = np.random.uniform(-0.5, 0.5, size=(100, n_in))
+    keras_prediction = model.predict(X)
+    hls_prediction = hls_model.predict(X).reshape(keras_prediction.shape)
+
+    if activation == 'exponential':
+        # exp is range reduced rather than read from a table, so only the fixed-point dense is left to account for
+        np.testing.assert_allclose(hls_prediction, keras_prediction, rtol=0.01)
+    else:
+        np.testing.assert_allclose(hls_prediction, keras_prediction, rtol=0.05, atol=0.02)
+
+
+@pytest.mark.parametrize('activation', ['relu', 'sigmoid', 'tanh'])
+@pytest.mark.parametrize('reuse_factor', [1, 4])
+def test_dense_activation_unfused(activation, reuse_factor, monkeypatch):
+    '''The fused kernel computes the same values as the Dense and Activation layers it replaces.'''
+    n_in = 8
+    n_out = 6
+
+    model = tf.keras.models.Sequential()
+    model.add(Dense(n_out, input_shape=(n_in,), activation=activation, name='dense'))
+    model.compile(optimizer='adam', loss='mse')
+
+    X = np.random.uniform(-2, 2, size=(100, n_in))
+    predictions = {}
+    for fused in [True, False]:
+        if not fused:
+            monkeypatch.setattr(FuseDenseActivation, 'match', lambda self, node: False)
+        config = hls4ml.utils.config_from_keras_model(model, default_precision='ap_fixed<24,10>', granularity='name')
+        config['LayerName']['dense']['ReuseFactor'] = reuse_factor
+        config['LayerName'][f'dense_{activation}']['ReuseFactor'] = reuse_factor
+        config['LayerName'][f'dense_{activation}']['table_ports'] = 1
+        output_dir = str(test_root_path / f'hls4mlprj_dense_activation_{activation}_rf{reuse_factor}_fused_{int(fused)}')
+        hls_model = hls4ml.converters.convert_from_keras_model(
+            model, hls_config=config, output_dir=output_dir, io_type='io_array_stream'
+        )
+        hls_model.compile()
+        if fused:
+            assert hls_model.graph['dense'].get_attr('table_ports') == 1
+        predictions[fused] = hls_model.predict(X)
+
+    np.testing.assert_array_equal(predictions[True], predictions[False])
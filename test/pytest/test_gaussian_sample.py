@@ -0,0 +1,173 @@
+from pathlib import Path
+
+import numpy as np
+import pytest
+import tensorflow as tf
+from tensorflow.keras.layers import Input
+
+import hls4ml
+
+test_root_path = Path(__file__).parent
+
+
+class GaussianSample(tf.keras.layers.Layer):
+    '''Keras reparameterization sample, mean + N(0, 1) * exp(0.5 * log_var), n_samples > 1 stacks draws after the batch,
+    or with interleave_samples after every timestep'''
+
+    def __init__(self, n_samples=1, interleave_samples=False, **kwargs):
+        super().__init__(**kwargs)
+        self.n_samples = n_samples
+        self.interleave_samples = interleave_samples
+
+    def call(self, inputs):
+        mean, log_var = inputs
+        samples = [mean + tf.random.normal(tf.shape(mean)) * tf.exp(0.5 * log_var) for _ in range(self.n_samples)]
+        if self.n_samples == 1:
+            return samples[0]
+        if self.interleave_samples:
+            stacked = tf.stack(samples, axis=2)
+            return tf.reshape(stacked, [-1, mean.shape[1] * self.n_samples] + list(mean.shape[2:]))
+        return tf.stack(samples, axis=1)
+
+    def get_config(self):
+        config = super().get_config()
+        config['n_samples'] = self.n_samples
+        config['interleave_samples'] = self.interleave_samples
+        return config
+
+
+@pytest.mark.parametrize(
+    'reuse_factor, rng_engine, exp_implementation',
+    [
+        (1, 'clt', 'table'),
+        (3, 'clt', 'table'),
+        (1, 'clt_shift', 'table'),
+        (1, 'inverse_cdf', 'table'),
+        (1, 'wallace', 'table'),
+        (3, 'philox', 'table'),
+        (3, 'clt', 'range_reduced'),
+    ],
+)
+def test_gaussian_sample(reuse_factor, rng_engine, exp_implementation):
+    n_elem = 8
+
+    mean_in = Input(shape=(n_elem,), name='mean')
+    log_var_in = Input(shape=(n_elem,), name='log_var')
+    out = GaussianSample(name='sample')([mean_in, log_var_in])
+    model = tf.keras.models.Model(inputs=[mean_in, log_var_in], outputs=out)
+
+    config = hls4ml.utils.config_from_keras_model(model, granularity='name')
+    config['LayerName']['sample']['ReuseFactor'] = reuse_factor
+    config['LayerName']['sample']['rng_engine'] = rng_engine
+    config['LayerName']['sample']['exp_implementation'] = exp_implementation
+    output_dir = str(test_root_path / f'hls4mlprj_gaussian_sample_rf{reuse_factor}_{rng_engine}_{exp_implementation}')
+    hls_model = hls4ml.converters.convert_from_keras_model(
+        model, hls_config=config, output_dir=output_dir, io_type='io_array_stream'
+    )
+    hls_model.compile()
+
+    n_samples = 500
+    std_dev = 0.5
+    X_mean = np.random.uniform(-2, 2, size=(n_samples, n_elem))
+    X_log_var = np.full((n_samples, n_elem), 2 * np.log(std_dev))
+    hls_prediction = hls_model.predict([X_mean, X_log_var]).reshape(X_mean.shape)
+
+    # The noise is standard normal and differs between samples
+    noise = (hls_prediction - X_mean) / std_dev
+    assert abs(np.mean(noise)) < 0.1
+    assert 0.8 < np.std(noise) < 1.2
+    assert not np.allclose(noise[0], noise[1])
+
+    # With several threads, every sample draws its own noise, so the result is independent of the thread count
+    hls_prediction_2 = hls_model.predict([X_mean, X_log_var], n_threads=2).reshape(X_mean.shape)
+    hls_prediction_mt = hls_model.predict([X_mean, X_log_var], n_threads=0).reshape(X_mean.shape)
+    np.testing.assert_array_equal(hls_prediction_2, hls_prediction_mt)
+
+
+def test_gaussian_sample_multi():
+    n_elem = 8
+    n_samples = 4
+
+    mean_in = Input(shape=(n_elem,), name='mean')
+    log_var_in = Input(shape=(n_elem,), name='log_var')
+    out = GaussianSample(n_samples, name='sample')([mean_in, log_var_in])
+    model = tf.keras.models.Model(inputs=[mean_in, log_var_in], outputs=out)
+
+    config = hls4ml.utils.config_from_keras_model(model, granularity='name')
+    output_dir = str(test_root_path / 'hls4mlprj_gaussian_sample_multi')
+    hls_model = hls4ml.converters.convert_from_keras_model(
+        model, hls_config=config, output_dir=output_dir, io_type='io_array_stream'
+    )
+    hls_model.compile()
+
+    n_inputs = 200
+    std_dev = 0.5
+    X_mean = np.random.uniform(-2, 2, size=(n_inputs, n_elem))
+    X_log_var = np.full((n_inputs, n_elem), 2 * np.log(std_dev))
+    hls_prediction = hls_model.predict([X_mean, X_log_var]).reshape(n_inputs, n_samples, n_elem)
+
+    # Every draw is standard normal noise around the same mean, and the draws differ
+    noise = (hls_prediction - X_mean[:, np.newaxis, :]) / std_dev
+    assert abs(np.mean(noise)) < 0.1
+    assert 0.8 < np.std(noise) < 1.2
+    assert not np.allclose(noise[:, 0], noise[:, 1])
+
+
+def test_gaussian_sample_gru():
+    '''The interleaved draws run as the trials of a downstream GRU, which takes n_batch from n_samples.'''
+    n_steps = 6
+    n_elem = 4
+    n_samples = 3
+    n_units = 8
+
+    mean_in = Input(shape=(n_steps, n_elem), name='mean')
+    log_var_in = Input(shape=(n_steps, n_elem), name='log_var')
+    sample = GaussianSample(n_samples, interleave_samples=True, name='sample')([mean_in, log_var_in])
+    out = tf.keras.layers.GRU(n_units, return_sequences=True, name='gru')(sample)
+    sample_model = tf.keras.models.Model(inputs=[mean_in, log_var_in], outputs=sample)
+    model = tf.keras.models.Model(inputs=[mean_in, log_var_in], outputs=out)
+
+    trial_model = tf.keras.models.Sequential()
+    trial_model.add(tf.keras.layers.GRU(n_units, input_shape=(n_steps, n_elem), return_sequences=True))
+    trial_model.set_weights(model.get_layer('gru').get_weights())
+
+    predictions = {}
+    for name, keras_model in [('sample', sample_model), ('gru', model)]:
+        config = hls4ml.utils.config_from_keras_model(keras_model, granularity='name', default_precision='ap_fixed<32,16>')
+        output_dir = str(test_root_path / f'hls4mlprj_gaussian_sample_gru_{name}')
+        hls_model = hls4ml.converters.convert_from_keras_model(
+            keras_model, hls_config=config, output_dir=output_dir, io_type='io_array_stream'
+        )
+        if name == 'gru':
+            assert hls_model.graph['gru'].get_attr('n_batch') == n_samples
+        hls_model.compile()
+
+        n_inputs = 20
+        np.random.seed(0)
+        X_mean = np.random.uniform(-1, 1, size=(n_inputs, n_steps, n_elem))
+        X_log_var = np.random.uniform(-2, 0, size=(n_inputs, n_steps, n_elem))
+        predictions[name] = hls_model.predict([X_mean, X_log_var])
+
+    # Both models draw the same noise, so the GRU trials are the Keras GRU run on each draw
+    draws = predictions['sample'].reshape(n_inputs, n_steps, n_samples, n_elem).transpose(0, 2, 1, 3)
+    keras_prediction = trial_model.predict(draws.reshape(-1, n_steps, n_elem)).reshape(n_inputs, n_samples, n_steps, n_units)
+    hls_prediction = predictions['gru'].reshape(n_inputs, n_steps, n_samples, n_units).transpose(0, 2, 1, 3)
+    np.testing.assert_allclose(hls_prediction, keras_prediction, rtol=0.0, atol=5e-2)
+
+
+def test_gaussian_sample_rnd_range():
+    '''rnd_t has to hold the range of the CLT sum, the other engines saturate.'''
+    n_elem = 8
+
+    mean_in = Input(shape=(n_elem,), name='mean')
+    log_var_in = Input(shape=(n_elem,), name='log_var')
+    out = GaussianSample(name='sample')([mean_in, log_var_in])
+    model = tf.keras.models.Model(inputs=[mean_in, log_var_in], outputs=out)
+
+    config = hls4ml.utils.config_from_keras_model(model, granularity='name')
+    config['LayerName']['sample']['n_uniforms'] = 8
+    output_dir = str(test_root_path / 'hls4mlprj_gaussian_sample_rnd_range')
+    with pytest.raises(Exception, match='cannot hold'):
+        hls4ml.converters.convert_from_keras_model(
+            model, hls_config=config, output_dir=output_dir, io_type='io_array_stream'
+        )
@@ -0,0 +1,52 @@
+from pathlib import Path
+
+import numpy as np
+import pytest
+import tensorflow as tf
+
+import hls4ml
+from contrib.kl_layer.kl_layer import KLLoss, register_kl_layer
+
+test_root_path = Path(__file__).parent
+
+register_kl_layer()
+
+
+@pytest.mark.parametrize(
+    'io_type, exp_implementation',
+    [('io_stream', 'range_reduced'), ('io_array_stream', 'range_reduced'), ('io_array_stream', 'table')],
+)
+def test_kl_layer_stream(io_type, exp_implementation):
+    '''The streaming KL kernels agree with the io_parallel one and with the exact KL.'''
+    n_steps = 2
+    n_elem = 10
+
+    mean_in = tf.keras.layers.Input(shape=(n_steps, n_elem), name='mean')
+    log_var_in = tf.keras.layers.Input(shape=(n_steps, n_elem), name='log_var')
+    out = KLLoss(name='kl')([mean_in, log_var_in])
+    model = tf.keras.models.Model(inputs=[mean_in, log_var_in], outputs=out)
+
+    X_mean = np.random.uniform(-2, 2, size=(100, n_steps, n_elem))
+    X_log_var = np.random.uniform(-2, 2, size=(100, n_steps, n_elem))
+    # The HLS kernels average over the timesteps as well as the lanes
+    kl_exact = -0.5 * np.mean(1 + X_log_var - X_mean**2 - np.exp(X_log_var), axis=(1, 2))
+
+    predictions = {}
+    for io in ['io_parallel', io_type]:
+        config = hls4ml.utils.config_from_keras_model(model, default_precision='ap_fixed<16,6>', granularity='name')
+        config['LayerName']['kl']['Precision'] = {'accum': 'ap_fixed<32,12>', 'result': 'ap_fixed<16,6>'}
+        config['LayerName']['kl']['ReuseFactor'] = 3
+        config['LayerName']['kl']['exp_implementation'] = exp_implementation
+        output_dir = str(test_root_path / f'hls4mlprj_kl_layer_{io}_{exp_implementation}')
+        hls_model = hls4ml.converters.convert_from_keras_model(model, hls_config=config, output_dir=output_dir, io_type=io)
+        hls_model.compile()
+        predictions[io] = hls_model.predict([X_mean, X_log_var]).flatten()
+
+    if exp_implementation == 'range_reduced':
+        # The io_parallel table has steps of 1/64 in log_var
+        np.testing.assert_allclose(predictions[io_type], predictions['io_parallel'], rtol=0, atol=0.02)
+        np.testing.assert_allclose(predictions[io_type], kl_exact, rtol=0, atol=5e-3)
+    else:
+        # The explogvar table is addressed by truncated bits, so exp(log_var) and the KL are biased low
+        np.testing.assert_allclose(predictions[io_type], predictions['io_parallel'], rtol=0, atol=0.06)
+        np.testing.assert_allclose(predictions[io_type], kl_exact, rtol=0, atol=0.06)
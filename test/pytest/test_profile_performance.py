@@ -0,0 +1,69 @@
+from pathlib import Path
+
+import numpy as np
+import pytest
+import tensorflow as tf
+from tensorflow.keras.layers import GRU, Activation, Dense
+
+import hls4ml
+
+test_root_path = Path(__file__).parent
+
+
+@pytest.mark.parametrize('io_type', ['io_parallel', 'io_stream', 'io_array_stream'])
+def test_profile_performance(io_type):
+    model = tf.keras.models.Sequential()
+    model.add(Dense(16, input_shape=(8,), name='dense1'))
+    model.add(Activation('relu', name='relu1'))
+    model.add(Dense(4, name='dense2'))
+    model.compile(optimizer='adam', loss='mse')
+
+    config = hls4ml.utils.config_from_keras_model(model, default_precision='ap_fixed<16,6>', granularity='name')
+    config['LayerName']['dense2']['ReuseFactor'] = 4
+    output_dir = str(test_root_path / f'hls4mlprj_profile_performance_{io_type}')
+    hls_model = hls4ml.converters.convert_from_keras_model(
+        model, hls_config=config, output_dir=output_dir, io_type=io_type
+    )
+    hls_model.compile()
+
+    X = np.random.uniform(-1, 1, size=(50, 8))
+    y = hls_model.predict(X)
+
+    profile = hls_model.profile_performance(X)
+
+    assert (Path(output_dir) / 'layer_profile.json').exists()
+    assert 'dense1' in profile and 'dense2' in profile
+    for layer_profile in profile.values():
+        assert layer_profile['invocations'] == len(X)
+        assert layer_profile['wall_time'] >= 0
+    assert profile['dense1']['macs'] == 8 * 16
+    assert profile['dense2']['macs'] == 16 * 4
+    assert profile['dense2']['cycles'] == 4
+
+    # Profiling does not change the results
+    np.testing.assert_array_equal(hls_model.predict(X), y)
+
+
+def test_profile_performance_gru():
+    '''The GRU cycle estimate follows the recurrent implementation and II.'''
+    n_timesteps = 10
+    model = tf.keras.models.Sequential()
+    model.add(GRU(8, input_shape=(n_timesteps, 4), return_sequences=True, name='gru1'))
+    model.compile(optimizer='adam', loss='mse')
+
+    costs = {}
+    for implementation in ['serial', 'pipelined']:
+        config = hls4ml.utils.config_from_keras_model(model, default_precision='ap_fixed<16,6>', granularity='name')
+        config['LayerName']['gru1']['RecurrentImplementation'] = implementation
+        config['LayerName']['gru1']['RecurrentII'] = 2
+        output_dir = str(test_root_path / f'hls4mlprj_profile_performance_gru_{implementation}')
+        hls_model = hls4ml.converters.convert_from_keras_model(
+            model, hls_config=config, output_dir=output_dir, io_type='io_array_stream'
+        )
+        layer = hls_model.graph['gru1']
+        costs[implementation] = hls_model.config.backend.get_layer_cost(layer)
+        step_latency = hls_model.config.backend.get_recurrent_step_latency(layer)
+
+    assert costs['serial']['cycles'] == n_timesteps * (1 + step_latency)
+    assert costs['pipelined']['cycles'] == n_timesteps * 2 + 1 + step_latency
+    assert costs['serial']['macs'] == costs['pipelined']['macs']
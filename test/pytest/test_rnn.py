@@ -2,6 +2,7 @@ from pathlib import Path
 
 import numpy as np
 import pytest
+from qkeras import QGRU, QBidirectional, quantized_bits, quantized_sigmoid, quantized_tanh
 from tensorflow.keras.layers import GRU, LSTM, Input, SimpleRNN
 from tensorflow.keras.models import Model, Sequential
 
@@ -124,3 +125,159 @@ def test_rnn_accuracy(rnn_layer, return_sequences, backend, io_type, strategy, s
     keras_prediction = keras_model.predict(X)
     hls_prediction = hls_model.predict(X)
     np.testing.assert_allclose(hls_prediction.flatten(), keras_prediction.flatten(), rtol=0.0, atol=5e-2)
+
+
+@pytest.mark.parametrize('static', [True, False])
+def test_gru_batched(static):
+    n_batch = 3
+    n_timesteps = 12
+    n_in = 8
+    X = np.random.rand(20, n_batch, n_timesteps, n_in) - 0.5
+
+    def make_model(time_steps):
+        keras_model = Sequential()
+        keras_model.add(GRU(units=16, input_shape=(time_steps, n_in), return_sequences=True, name='gru'))
+        keras_model.compile()
+        return keras_model
+
+    # The trials are interleaved along the timestep axis of the hls4ml model
+    trial_model = make_model(n_timesteps)
+    batched_model = make_model(n_batch * n_timesteps)
+    batched_model.set_weights(trial_model.get_weights())
+
+    hls_config = hls4ml.utils.config_from_keras_model(
+        batched_model, granularity='name', default_precision='ap_fixed<32, 16>'
+    )
+    hls_config['LayerName']['gru']['static'] = static
+    hls_config['LayerName']['gru']['NBatch'] = n_batch
+    output_dir = str(test_root_path / f'hls4mlprj_gru_batched_static_{int(static)}')
+    hls_model = hls4ml.converters.convert_from_keras_model(
+        batched_model, hls_config=hls_config, output_dir=output_dir, io_type='io_array_stream'
+    )
+    hls_model.compile()
+
+    X_interleaved = X.transpose(0, 2, 1, 3).reshape(-1, n_batch * n_timesteps, n_in)
+    hls_prediction = hls_model.predict(X_interleaved).reshape(-1, n_timesteps, n_batch, 16).transpose(0, 2, 1, 3)
+    keras_prediction = trial_model.predict(X.reshape(-1, n_timesteps, n_in)).reshape(X.shape[:3] + (16,))
+    np.testing.assert_allclose(hls_prediction, keras_prediction, rtol=0.0, atol=5e-2)
+
+
+@pytest.mark.parametrize('return_sequences', [True, False])
+@pytest.mark.parametrize('static', [True, False])
+def test_gru_implementations(return_sequences, static):
+    '''The pipelined and precomputed timestep loops compute the same values as the serial one.'''
+    input_shape = (12, 8)
+    X = np.random.rand(50, *input_shape) - 0.5
+
+    keras_model = Sequential()
+    keras_model.add(GRU(units=16, input_shape=input_shape, return_sequences=return_sequences, name='gru'))
+    keras_model.compile()
+
+    predictions = {}
+    for implementation in ['serial', 'pipelined', 'precomputed']:
+        hls_config = hls4ml.utils.config_from_keras_model(
+            keras_model, granularity='name', default_precision='ap_fixed<32, 16>'
+        )
+        hls_config['LayerName']['gru']['static'] = static
+        hls_config['LayerName']['gru']['RecurrentImplementation'] = implementation
+        output_dir = str(
+            test_root_path
+            / f'hls4mlprj_gru_implementation_{implementation}_static_{int(static)}_ret_seq_{int(return_sequences)}'
+        )
+        hls_model = hls4ml.converters.convert_from_keras_model(
+            keras_model, hls_config=hls_config, output_dir=output_dir, io_type='io_array_stream'
+        )
+        hls_model.compile()
+        predictions[implementation] = hls_model.predict(X)
+
+    np.testing.assert_array_equal(predictions['pipelined'], predictions['serial'])
+    np.testing.assert_array_equal(predictions['precomputed'], predictions['serial'])
+    np.testing.assert_allclose(
+        predictions['serial'].flatten(), keras_model.predict(X).flatten(), rtol=0.0, atol=5e-2
+    )
+
+
+@pytest.mark.parametrize('io_type', ['io_parallel', 'io_stream'])
+def test_gru_implementation_io_type(io_type):
+    '''Only the io_array_stream GRU has other timestep loops than the serial one.'''
+    keras_model = Sequential()
+    keras_model.add(GRU(units=16, input_shape=(12, 8), name='gru'))
+    keras_model.compile()
+
+    hls_config = hls4ml.utils.config_from_keras_model(keras_model, granularity='name')
+    hls_config['LayerName']['gru']['RecurrentImplementation'] = 'pipelined'
+    output_dir = str(test_root_path / f'hls4mlprj_gru_implementation_{io_type}')
+    with pytest.raises(Exception, match='RecurrentImplementation'):
+        hls4ml.converters.convert_from_keras_model(
+            keras_model, hls_config=hls_config, output_dir=output_dir, io_type=io_type
+        )
+
+
+@pytest.mark.parametrize('io_type', ['io_parallel', 'io_stream', 'io_array_stream'])
+def test_gru_threads(io_type):
+    '''The state of a static GRU belongs to the sample, so predictions do not depend on the number of threads.'''
+    input_shape = (12, 8)
+    X = np.random.rand(200, *input_shape) - 0.5
+
+    keras_model = Sequential()
+    keras_model.add(GRU(units=16, input_shape=input_shape, return_sequences=True, name='gru'))
+    keras_model.compile()
+
+    hls_config = hls4ml.utils.config_from_keras_model(keras_model, granularity='name', default_precision='ap_fixed<32, 16>')
+    hls_config['LayerName']['gru']['static'] = True
+    output_dir = str(test_root_path / f'hls4mlprj_gru_threads_{io_type}')
+    hls_model = hls4ml.converters.convert_from_keras_model(
+        keras_model, hls_config=hls_config, output_dir=output_dir, io_type=io_type
+    )
+    hls_model.compile()
+
+    hls_prediction = hls_model.predict(X, n_threads=1)
+    for n_threads in [2, 4, 0]:
+        np.testing.assert_array_equal(hls_model.predict(X, n_threads=n_threads), hls_prediction)
+    np.testing.assert_allclose(hls_prediction.flatten(), keras_model.predict(X).flatten(), rtol=0.0, atol=5e-2)
+
+
+@pytest.mark.parametrize('implementation', ['sequential', 'concurrent', 'streaming'])
+def test_bidirectional(implementation):
+    '''The bidirectional GRU matches QKeras, and the concurrent and streaming schedules the sequential one.'''
+    input_shape = (8, 6)
+    X = np.random.rand(50, *input_shape) - 0.5
+
+    quantizer = quantized_bits(16, 4, alpha=1)
+    keras_model = Sequential()
+    keras_model.add(
+        QBidirectional(
+            QGRU(
+                units=8,
+                activation=quantized_tanh(16),
+                recurrent_activation=quantized_sigmoid(16),
+                kernel_quantizer=quantizer,
+                recurrent_quantizer=quantizer,
+                bias_quantizer=quantizer,
+                state_quantizer=quantizer,
+                reset_after=True,
+            ),
+            input_shape=input_shape,
+            name='bidirectional',
+        )
+    )
+    keras_model.compile()
+
+    predictions = {}
+    for impl in {'sequential', implementation}:
+        hls_config = hls4ml.utils.config_from_keras_model(
+            keras_model, granularity='name', default_precision='ap_fixed<32, 16>'
+        )
+        hls_config['LayerName']['bidirectional']['implementation'] = impl
+        output_dir = str(test_root_path / f'hls4mlprj_bidirectional_{impl}')
+        hls_model = hls4ml.converters.convert_from_keras_model(
+            keras_model, hls_config=hls_config, output_dir=output_dir, io_type='io_array_stream'
+        )
+        hls_model.compile()
+        predictions[impl] = hls_model.predict(X)
+
+    np.testing.assert_array_equal(predictions[implementation], predictions['sequential'])
+    keras_prediction = keras_model.predict(X)
+    np.testing.assert_allclose(
+        predictions[implementation].reshape(keras_prediction.shape), keras_prediction, rtol=0.0, atol=5e-2
+    )
@@ -0,0 +1,36 @@
+from pathlib import Path
+
+import numpy as np
+import pytest
+import tensorflow as tf
+from tensorflow.keras.layers import Activation, Dense
+
+import hls4ml
+
+test_root_path = Path(__file__).parent
+
+
+@pytest.mark.parametrize('io_type', ['io_stream', 'io_array_stream'])
+def test_stream_ring_buffer(io_type, monkeypatch):
+    model = tf.keras.models.Sequential()
+    model.add(Dense(16, input_shape=(8,), name='dense1'))
+    model.add(Activation('relu', name='relu1'))
+    model.add(Dense(4, name='dense2'))
+    model.compile(optimizer='adam', loss='mse')
+
+    config = hls4ml.utils.config_from_keras_model(model, default_precision='ap_fixed<16,6>')
+    X = np.random.uniform(-1, 1, size=(100, 8))
+
+    predictions = []
+    for ring_buffer in [False, True]:
+        if ring_buffer:
+            monkeypatch.setenv('HLS4ML_STREAM_RING_BUFFER', '1')
+        output_dir = str(test_root_path / f'hls4mlprj_stream_ring_buffer_{io_type}_{int(ring_buffer)}')
+        hls_model = hls4ml.converters.convert_from_keras_model(
+            model, hls_config=config, output_dir=output_dir, io_type=io_type
+        )
+        hls_model.compile()
+        predictions.append(hls_model.predict(X))
+
+    # The C-simulation model of hls::stream must not change the results
+    np.testing.assert_array_equal(predictions[0], predictions[1])
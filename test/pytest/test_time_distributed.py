@@ -0,0 +1,40 @@
+from pathlib import Path
+
+import numpy as np
+import pytest
+import tensorflow as tf
+from tensorflow.keras.layers import Dense, TimeDistributed
+
+import hls4ml
+
+test_root_path = Path(__file__).parent
+
+
+@pytest.mark.parametrize('strategy, reuse_factor', [('Latency', 1), ('Latency', 4), ('Resource', 4)])
+def test_time_distributed_dense(strategy, reuse_factor):
+    n_sequence = 10
+    n_in = 8
+    n_out = 6
+
+    model = tf.keras.models.Sequential()
+    model.add(TimeDistributed(Dense(n_out), input_shape=(n_sequence, n_in), name='td_dense'))
+    model.compile(optimizer='adam', loss='mse')
+
+    config = hls4ml.utils.config_from_keras_model(model, default_precision='ap_fixed<32,16>', granularity='name')
+    config['LayerName']['td_dense']['Strategy'] = strategy
+    config['LayerName']['td_dense']['ReuseFactor'] = reuse_factor
+    output_dir = str(test_root_path / f'hls4mlprj_time_distributed_dense_{strategy}_rf{reuse_factor}')
+    hls_model = hls4ml.converters.convert_from_keras_model(
+        model, hls_config=config, output_dir=output_dir, io_type='io_array_stream'
+    )
+    hls_model.compile()
+
+    # Every timestep goes through the same weights
+    assert hls_model.graph['td_dense'].get_attr('n_sequence') == n_sequence
+    assert hls_model.graph['td_dense'].get_attr('sequence_ii') == reuse_factor
+
+    X = np.random.uniform(-1, 1, size=(100, n_sequence, n_in))
+    keras_prediction = model.predict(X)
+    hls_prediction = hls_model.predict(X).reshape(keras_prediction.shape)
+
+    np.testing.assert_allclose(hls_prediction, keras_prediction, rtol=0, atol=1e-2)
@@ -0,0 +1,79 @@
+from pathlib import Path
+
+import numpy as np
+import pytest
+import tensorflow as tf
+from tensorflow.keras.layers import Activation, Dense, TimeDistributed
+
+import hls4ml
+import hls4ml.model.profiling
+
+test_root_path = Path(__file__).parent
+
+
+@pytest.mark.parametrize('io_type', ['io_stream', 'io_array_stream'])
+@pytest.mark.parametrize('threads', [False, True])
+def test_trace_array_stream(io_type, threads, monkeypatch):
+    '''Test tracing the streams between the layers as they are written.'''
+    n_sequence = 10
+
+    model = tf.keras.models.Sequential()
+    model.add(TimeDistributed(Dense(16), input_shape=(n_sequence, 8), name='dense1'))
+    model.add(Activation('relu', name='relu1'))
+    model.add(TimeDistributed(Dense(4), name='dense2'))
+    model.compile(optimizer='adam', loss='mse')
+
+    X = np.random.uniform(-1, 1, size=(20, n_sequence, 8))
+
+    config = hls4ml.utils.config_from_keras_model(model, default_precision='ap_fixed<16,6>', granularity='name')
+    for layer in config['LayerName'].keys():
+        config['LayerName'][layer]['Trace'] = True
+
+    if threads:
+        monkeypatch.setenv('HLS4ML_STREAM_RING_BUFFER', '1')
+        monkeypatch.setenv('HLS4ML_DATAFLOW_THREADS', '1')
+
+    output_dir = str(test_root_path / f'hls4mlprj_trace_array_stream_{io_type}_threads{int(threads)}')
+    hls_model = hls4ml.converters.convert_from_keras_model(
+        model, hls_config=config, output_dir=output_dir, io_type=io_type
+    )
+    hls_model.compile()
+    y_hls = hls_model.predict(X)
+    hls4ml_pred, hls4ml_trace = hls_model.trace(X)
+    keras_trace = hls4ml.model.profiling.get_ymodel_keras(model, X)
+
+    # Tapping the streams must not disturb the layers that read them
+    np.testing.assert_array_equal(hls4ml_pred, y_hls)
+    np.testing.assert_array_equal(hls4ml_trace['dense2'].reshape(y_hls.shape), y_hls)
+    for layer in ['dense1', 'relu1']:
+        np.testing.assert_allclose(hls4ml_trace[layer], keras_trace[layer], rtol=1e-2, atol=0.05)
+
+
+def test_trace_multiple_outputs():
+    '''Test tracing a layer with several output streams, the clone of a stream read by two layers.'''
+    inp = tf.keras.layers.Input(shape=(8,), name='input1')
+    x = Dense(16, name='dense1')(inp)
+    y1 = Dense(4, name='dense2')(x)
+    y2 = Dense(4, name='dense3')(x)
+    out = tf.keras.layers.Add(name='add1')([y1, y2])
+    model = tf.keras.models.Model(inputs=inp, outputs=out)
+    model.compile(optimizer='adam', loss='mse')
+
+    X = np.random.uniform(-1, 1, size=(20, 8))
+
+    config = hls4ml.utils.config_from_keras_model(model, default_precision='ap_fixed<16,6>', granularity='name')
+    config['LayerName']['clone_dense1'] = {'Trace': True}
+
+    output_dir = str(test_root_path / 'hls4mlprj_trace_multiple_outputs')
+    hls_model = hls4ml.converters.convert_from_keras_model(
+        model, hls_config=config, output_dir=output_dir, io_type='io_stream'
+    )
+    hls_model.compile()
+    y_hls = hls_model.predict(X)
+    hls4ml_pred, hls4ml_trace = hls_model.trace(X)
+    keras_trace = hls4ml.model.profiling.get_ymodel_keras(model, X)
+
+    np.testing.assert_array_equal(hls4ml_pred, y_hls)
+    # The first copy is traced under the layer name, the second under its output name
+    np.testing.assert_array_equal(hls4ml_trace['clone_dense1'], hls4ml_trace['dense1_cpy2'])
+    np.testing.assert_allclose(hls4ml_trace['clone_dense1'], keras_trace['dense1'], rtol=1e-2, atol=0.05)
@@ -0,0 +1,65 @@
+import os
+from pathlib import Path
+
+import numpy as np
+import pytest
+import tensorflow as tf
+from tensorflow.keras.layers import Activation, Dense
+
+import hls4ml
+
+test_root_path = Path(__file__).parent
+
+
+@pytest.fixture(scope='module')
+def model():
+    model = tf.keras.models.Sequential()
+    model.add(Dense(16, input_shape=(8,), name='dense1'))
+    model.add(Activation('relu', name='relu1'))
+    model.add(Dense(4, name='dense2'))
+    model.compile(optimizer='adam', loss='mse')
+    return model
+
+
+def _convert(model, name):
+    config = hls4ml.utils.config_from_keras_model(model, default_precision='ap_fixed<16,6>')
+    output_dir = str(test_root_path / f'hls4mlprj_weights_bin_{name}')
+    hls_model = hls4ml.converters.convert_from_keras_model(
+        model, hls_config=config, output_dir=output_dir, io_type='io_parallel'
+    )
+    hls_model.compile()
+    return hls_model, Path(output_dir) / 'firmware' / 'weights'
+
+
+def test_weights_bin_txt(model):
+    '''The weights loaded from the .bin files are the ones written to the .txt files.'''
+    X = np.random.uniform(-1, 1, size=(100, 8))
+
+    hls_model, weights_dir = _convert(model, 'bin')
+    assert len(list(weights_dir.glob('*.bin'))) == 4
+    y_bin = hls_model.predict(X)
+
+    # The weights are only read on the first call, so the .bin files can go after compiling
+    hls_model, weights_dir = _convert(model, 'txt')
+    for bin_file in weights_dir.glob('*.bin'):
+        bin_file.unlink()
+    y_txt = hls_model.predict(X)
+
+    np.testing.assert_array_equal(y_bin, y_txt)
+
+
+def test_weights_txt_newer(model):
+    '''A .txt file modified after the .bin file was written is loaded instead of it.'''
+    X = np.random.uniform(-1, 1, size=(100, 8))
+
+    hls_model, weights_dir = _convert(model, 'edited')
+    dense2 = hls_model.graph['dense2']
+    for var, value in [(dense2.weights['weight'], 0), (dense2.weights['bias'], 1)]:
+        txt_file = weights_dir / f'{var.name}.txt'
+        txt_file.write_text(', '.join([str(value)] * var.data_length))
+        # Modification times may only be kept to the second
+        bin_mtime = os.stat(weights_dir / f'{var.name}.bin').st_mtime
+        os.utime(txt_file, (bin_mtime + 10, bin_mtime + 10))
+    y_hls = hls_model.predict(X)
+
+    np.testing.assert_array_equal(y_hls, np.ones((100, 4)))